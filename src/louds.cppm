@@ -5,8 +5,21 @@ module;
 #include <cstddef>
 #include <cassert>
 #include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
 #include <concepts>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <span>
 #include <type_traits>
+#include <utility>
+
+#if defined(_MSC_VER) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
 export module louds;
 
@@ -29,24 +42,334 @@ namespace louds {
 
     export const ThingRef NilRef = {0, 0};
 
+    static_assert(sizeof(ThingRef) == 2 * sizeof(uint32_t), "ThingRef must stay two packed 32-bit words.");
+
+    // Epoch-based reclamation for reading a pool from other threads while its owner keeps
+    // spawning and destroying. Readers pin the current epoch; destroyed slots are only reused
+    // once every pinned reader has moved past the epoch they were retired in.
+    export class EpochDomain {
+    public:
+        static constexpr size_t max_readers = 64;
+
+        class Guard {
+            friend class EpochDomain;
+
+            EpochDomain* domain = nullptr;
+            size_t slot = 0;
+
+            Guard(EpochDomain* d, size_t s) : domain(d), slot(s) {}
+
+        public:
+            Guard(Guard&& other) noexcept : domain(std::exchange(other.domain, nullptr)), slot(other.slot) {}
+
+            Guard& operator=(Guard&& other) noexcept {
+                if (this != &other) {
+                    release();
+                    domain = std::exchange(other.domain, nullptr);
+                    slot = other.slot;
+                }
+                return *this;
+            }
+
+            Guard(const Guard&) = delete;
+            Guard& operator=(const Guard&) = delete;
+
+            ~Guard() { release(); }
+
+            void release() {
+                if (domain == nullptr) return;
+                domain->unpin(slot);
+                domain = nullptr;
+            }
+        };
+
+        // Reader threads. Each thread uses its own reader_slot in [0, max_readers).
+        Guard pin(size_t reader_slot);
+
+        // Owning thread. Moves to the next epoch once every pinned reader has observed the current one.
+        bool try_advance();
+
+        uint64_t epoch() const;
+
+    private:
+        static constexpr uint64_t idle = ~uint64_t{0};
+
+        struct alignas(64) ReaderSlot {
+            std::atomic<uint64_t> epoch{idle};
+        };
+
+        std::atomic<uint64_t> global_epoch{1};
+        ReaderSlot readers[max_readers];
+
+        void unpin(size_t reader_slot);
+    };
+
     namespace detail {
-        bool write_pool_to_disk(const char* filepath, const void* header, size_t header_size, 
-                                const void* next_free, size_t free_size, 
-                                const void* nodes, size_t nodes_size);
+        // Snapshot files are a pool section followed by any number of side-table sections.
+        struct FileSection {
+            const void* data = nullptr;
+            size_t size = 0;
+        };
+
+        struct FileSpan {
+            void* data = nullptr;
+            size_t size = 0;
+        };
+
+        bool write_file_sections(const char* filepath, std::span<const FileSection> sections);
+
+        // Reads sections back to back, starting offset bytes into the file. Fails on a short file.
+        bool read_file_sections(const char* filepath, size_t offset, std::span<const FileSpan> sections);
+
+        // Leads each SideTable section of a snapshot.
+        struct SideTableHeader {
+            char magic[4] = {'L', 'O', 'S', 'T'};
+            uint32_t value_size = 0;
+            uint32_t count = 0;
+        };
+
+        // Byte stream helpers shared by the replication encoder/decoder.
+        struct ByteWriter {
+            uint8_t* data = nullptr;
+            size_t capacity = 0;
+            size_t size = 0;
+            bool overflow = false;
+        };
+
+        struct ByteReader {
+            const uint8_t* data = nullptr;
+            size_t size = 0;
+            size_t offset = 0;
+        };
+
+        void write_varint(ByteWriter& out, uint64_t value);
+        bool read_varint(ByteReader& in, uint64_t& value);
+
+        // Writes `current XOR baseline` as alternating (zero run, literal run) pairs.
+        // A null baseline is treated as all zeros.
+        void write_xor_runs(ByteWriter& out, const void* current, const void* baseline, size_t size);
+
+        // XORs decoded literals into `target`, which must hold the baseline bytes.
+        // A null target only validates and skips the encoded runs.
+        bool read_xor_runs(ByteReader& in, void* target, size_t size);
+
+        // Page-granular copy-on-write memory used by ForkablePool.
+        struct SharedRegion {
+            void* address = nullptr;
+            size_t size = 0;
+            intptr_t handle = -1;
+        };
+
+        bool create_shared_region(size_t size, SharedRegion& region);
+        void destroy_shared_region(SharedRegion& region);
+        void* map_private_copy(const SharedRegion& region);
+        void unmap_private_copy(void* address, size_t size);
+        // Replaces the view at region.address with a private copy-on-write view of the same file.
+        bool remap_private(const SharedRegion& region);
+        // Closes the file handle but leaves region.address mapped.
+        void close_region_handle(SharedRegion& region);
+
+        inline void prefetch(const void* address) {
+#if defined(_MSC_VER)
+            _mm_prefetch(static_cast<const char*>(address), _MM_HINT_T0);
+#else
+            __builtin_prefetch(address);
+#endif
+        }
+
+        constexpr size_t max_varint_size = 10;
+
+        constexpr size_t max_xor_runs_size(size_t size) {
+            return size + (size / 2 + 1) * 2 * max_varint_size;
+        }
+    }
+
+    // Fixed-size bitset indexed by ThingIdx, iterated a 64-bit word at a time.
+    export template <size_t BITS>
+    class SlotBitmap {
+    public:
+        static constexpr size_t word_count = (BITS + 63) / 64;
+
+        void set(size_t i) { words_[i >> 6] |= uint64_t{1} << (i & 63); }
+        void reset(size_t i) { words_[i >> 6] &= ~(uint64_t{1} << (i & 63)); }
+        bool test(size_t i) const { return (words_[i >> 6] >> (i & 63)) & 1; }
+        void clear() { std::fill_n(words_, word_count, uint64_t{0}); }
+        uint64_t word(size_t w) const { return words_[w]; }
+
+        size_t count() const {
+            size_t total = 0;
+            for (const uint64_t w : words_) total += static_cast<size_t>(std::popcount(w));
+            return total;
+        }
+
+        template <typename Fn>
+        void for_each(Fn&& fn) const {
+            for (size_t w = 0; w < word_count; ++w) {
+                for (uint64_t bits = words_[w]; bits != 0; bits &= bits - 1) {
+                    fn(static_cast<ThingIdx>(w * 64 + static_cast<size_t>(std::countr_zero(bits))));
+                }
+            }
+        }
+
+    private:
+        uint64_t words_[word_count] = {};
+    };
+
+    // When ThingPool resets a freed slot's payload to T{}.
+    export enum class ScrubPolicy : uint8_t {
+        // destroy() clears the payload, so dead data never lingers in memory, snapshots or
+        // published views. spawn() skips the reset for slots that are already clean.
+        eager,
+        // destroy() leaves the payload alone; spawn() resets it before handing the slot out.
+        lazy_on_spawn,
+        // Nobody resets it. spawn() may return the previous occupant's bytes; initialize
+        // through spawn_with().
+        none,
+    };
 
-        bool read_pool_from_disk(const char* filepath, void* header, size_t header_size, 
-                                 void* next_free, size_t free_size, 
-                                 void* nodes, size_t nodes_size);
+    // Lifecycle hooks that do nothing. A hooks type may define any of
+    //   void on_spawn(std::span<const ThingRef> spawned);
+    //   void on_destroy(std::span<const ThingRef> destroyed);
+    //   void on_reset();
+    // ThingPool calls the first two with batches of refs, and on_reset() after operations that
+    // replace or move things wholesale. Missing members cost nothing.
+    export struct NoHooks {};
+
+    // Compile-time configuration for ThingPool. Derive from it and override members to customize.
+    export struct DefaultPoolPolicy {
+        // Width of the generation counter handed out in ThingRef. A slot whose generation reaches
+        // the largest representable value is retired on destroy instead of wrapping around.
+        static constexpr unsigned generation_bits = 32;
+
+        // Software prefetch tuning. 0 disables the corresponding prefetch.
+        // Slots ahead of the cursor prefetched by iteration, for_kind() and queue_destroy_if().
+        static constexpr size_t scan_prefetch_distance = 4;
+        // Siblings ahead of the current child prefetched while walking a child chain in destroy().
+        static constexpr size_t hierarchy_lookahead = 2;
+        // Refs ahead of the cursor whose nodes validate_batch() / resolve_batch() prefetch.
+        static constexpr size_t batch_prefetch_distance = 8;
+
+        // Thread the free-list through inactive nodes' sibling links instead of a separate
+        // next_free array. Saves 4 bytes per slot in memory and in snapshots.
+        static constexpr bool intrusive_free_list = false;
+        // Capacity of the destroy_later() queue. 0 means MAX_THINGS - 1.
+        static constexpr size_t max_pending_destroy = 0;
+        // When freed payloads are reset to T{}. See ScrubPolicy.
+        static constexpr ScrubPolicy scrub = ScrubPolicy::lazy_on_spawn;
+        // Parent/child links per node. Without them attach_child()/detach() are unavailable and
+        // destroy() frees exactly one slot.
+        static constexpr bool hierarchy = true;
+        // Track free slots in a two-level bitmap and a doubly-linked free-list, so spawn_near() and
+        // spawn_child() can take a free slot next to a hint. Costs one bit per slot, plus 4 bytes
+        // per slot unless intrusive_free_list is set.
+        static constexpr bool locality_bitmap = false;
+        // Width of the per-slot tag masks queried by for_tags(): 0 (no tags), 32 or 64. The top bit
+        // is reserved by the pool.
+        static constexpr unsigned tag_bits = 0;
+        // Per-slot modification ticks for for_changed_since(), set by spawn(), touch() and get_mut().
+        // Costs 8 bytes per slot plus 8 bytes per 64 slots.
+        static constexpr bool change_ticks = false;
+        // Lifecycle hooks object stored in the pool (see NoHooks); reach it through hooks().
+        using hooks = NoHooks;
+    };
+
+    // For flat pools (particles, projectiles, decals) that never call attach_child().
+    export struct NoHierarchy : DefaultPoolPolicy {
+        static constexpr bool hierarchy = false;
+    };
+
+    export struct PoolStats {
+        size_t live_count = 0;
+        size_t retired_slots = 0;
+        // Slots invalidated by destroy_incremental() that reclaim_destroyed() has not freed yet.
+        size_t pending_reclaim = 0;
+    };
+
+    // Resume point of ThingPool::for_kind_budget(). Keep one per system, across frames.
+    export struct PassCursor {
+        ThingIdx next = 1;
+        // Incremented each time the cursor wraps past the last slot.
+        uint64_t passes = 0;
+    };
+
+    // Slot order produced by ThingPool::reorder().
+    export enum class ReorderPolicy : uint8_t {
+        // Current relative order, packed into the lowest slots.
+        slot_order,
+        // Grouped by payload .kind (stable within a kind), so for_kind() streams contiguous runs.
+        by_kind,
+        // Each root followed by its subtree in depth-first pre-order.
+        hierarchy_dfs,
+    };
+
+    // One entry per old slot index, written by ThingPool::reorder().
+    export struct RefRemap {
+        Generation old_generation = 0;
+        ThingRef new_ref = NilRef;
+    };
+
+    // Where ref lives after a reorder(); NilRef if ref was already stale.
+    export inline ThingRef remap_ref(std::span<const RefRemap> table, ThingRef ref) {
+        if (ref.index == 0 || ref.index >= table.size()) return NilRef;
+        const RefRemap& entry = table[ref.index];
+        return entry.old_generation == ref.generation ? entry.new_ref : NilRef;
     }
 
+    // Per-client copy of the last state sent through ThingPool::encode_delta().
     export template <typename T, size_t MAX_THINGS>
+    class ReplicationBaseline {
+        template <typename, size_t, typename> friend class ThingPool;
+
+        struct Slot {
+            Generation generation = 0;
+            ThingIdx links[4] = {};
+            T data{};
+        };
+
+        Slot slots[MAX_THINGS] = {};
+        SlotBitmap<MAX_THINGS> active;
+        bool full_resync = true;
+
+    public:
+        void reset() { full_resync = true; }
+        bool needs_full_resync() const { return full_resync; }
+    };
+
+    export template <typename T, size_t MAX_THINGS, typename Policy = DefaultPoolPolicy>
+    class PoolView;
+
+    export template <typename T, size_t MAX_THINGS, typename Policy = DefaultPoolPolicy>
     class ThingPool {
         static_assert(MAX_THINGS >= 2, "ThingPool requires MAX_THINGS >= 2.");
+        static_assert(Policy::generation_bits >= 1 && Policy::generation_bits <= 32,
+                      "ThingPool requires 1 <= Policy::generation_bits <= 32.");
+
+        static constexpr size_t pending_capacity =
+            Policy::max_pending_destroy == 0 ? MAX_THINGS - 1 : Policy::max_pending_destroy;
+        static_assert(pending_capacity <= ThingIdx(~ThingIdx{0}), "ThingPool pending destroy capacity must fit ThingIdx.");
+        static_assert(Policy::hierarchy || !Policy::intrusive_free_list,
+                      "ThingPool: intrusive_free_list threads through hierarchy links; NoHierarchy pools keep next_free.");
+        static_assert(Policy::tag_bits == 0 || Policy::tag_bits == 32 || Policy::tag_bits == 64,
+                      "ThingPool requires Policy::tag_bits to be 0, 32 or 64.");
+
+        template <typename, size_t, size_t, typename> friend class ViewPublisher;
+        template <typename, size_t, typename> friend class ForkablePool;
+
+    public:
+        static constexpr size_t max_things = MAX_THINGS;
+        static constexpr Generation max_generation =
+            Policy::generation_bits == 32 ? ~Generation{0} : Generation((uint64_t{1} << Policy::generation_bits) - 1);
+
+        using TagMask = std::conditional_t<Policy::tag_bits == 64, uint64_t, uint32_t>;
+        // Tag bits available to callers; the top bit marks live slots in the tag array.
+        static constexpr TagMask user_tags = TagMask(~TagMask{0} >> 1);
 
     private:
-        struct Node {
+        struct LinkedNode {
             Generation generation = 0;
             bool is_active = false;
+            // data still equals T{}; lets spawn() skip the reset. Lives in padding.
+            bool payload_clean = true;
 
             ThingIdx parent = 0;
             ThingIdx first_child = 0;
@@ -56,265 +379,3024 @@ namespace louds {
             T data{}; 
         };
 
+        // Policy::hierarchy == false: no links, so destroy() is a plain free-list push.
+        struct FlatNode {
+            Generation generation = 0;
+            bool is_active = false;
+            bool payload_clean = true;
+
+            T data{};
+        };
+
+        using Node = std::conditional_t<Policy::hierarchy, LinkedNode, FlatNode>;
+
         struct SaveHeader {
             char magic[4] = {'L', 'O', 'G', 'C'};
-            uint32_t version = 1;
+            uint32_t version = 3;
             uint32_t max_things = MAX_THINGS;
             uint32_t node_size = sizeof(Node);
-            ThingIdx first_free = 1;
+            ThingIdx first_free = 0;
+            ThingIdx high_water = 1;
+            uint32_t flags = 0;
+        };
+
+        // No next_free section: the free-list lives in the saved nodes.
+        static constexpr uint32_t save_flag_intrusive = 1;
+        // The saved free-list is incomplete and is rebuilt from the nodes on load.
+        static constexpr uint32_t save_flag_rebuild = 2;
+
+        struct NoFreeArray {};
+        using FreeArray = std::conditional_t<Policy::intrusive_free_list, NoFreeArray, ThingIdx[MAX_THINGS]>;
+
+        // Policy::locality_bitmap: one bit per free slot, plus one summary bit per non-empty word.
+        // Words are only trusted below `constructed`; see grow_high_water().
+        static constexpr size_t free_word_count = (MAX_THINGS + 63) / 64;
+        struct FreeBitmap {
+            uint64_t words[free_word_count];
+            uint64_t summary[(free_word_count + 63) / 64];
+        };
+        struct NoFreeBitmap {};
+        struct NoPrevArray {};
+        using FreeBits = std::conditional_t<Policy::locality_bitmap, FreeBitmap, NoFreeBitmap>;
+        using PrevArray = std::conditional_t<Policy::locality_bitmap && !Policy::intrusive_free_list,
+                                             ThingIdx[MAX_THINGS], NoPrevArray>;
+        // Policy::tag_bits: dense per-slot tag masks, valid below high_water. Dead slots hold 0.
+        static constexpr TagMask tag_live = TagMask(~user_tags);
+        struct NoTagArray {};
+        using TagArray = std::conditional_t<Policy::tag_bits != 0, TagMask[MAX_THINGS], NoTagArray>;
+        // Policy::change_ticks: last change of each slot, and the newest change in each 64-slot chunk
+        // so for_changed_since() can skip whole chunks. Chunk ticks may run ahead of their slots.
+        struct ChangeTicks {
+            uint64_t current = 1;
+            uint64_t slots[MAX_THINGS];
+            uint64_t chunks[(MAX_THINGS + 63) / 64];
         };
+        struct NoChangeTicks {};
+        using ChangeTickArrays = std::conditional_t<Policy::change_ticks, ChangeTicks, NoChangeTicks>;
 
-        Node nodes[MAX_THINGS] = {};
-        ThingIdx next_free[MAX_THINGS] = {};
-        ThingIdx first_free = 1;
-        ThingRef pending_destroy[MAX_THINGS - 1] = {};
+        // Free slots in the same page as a hint are preferred; at least one bitmap word.
+        static constexpr size_t locality_region_words = std::max<size_t>(1, 4096 / sizeof(Node) / 64);
+
+        // Storage is left untouched until used, so constructing a pool does not commit its pages.
+        // Slots [1, high_water) have been handed out since construction or clear(); everything at or
+        // above high_water is never read. Slots [0, constructed) hold constructed Nodes.
+        union {
+            Node nodes[MAX_THINGS];
+        };
+        [[no_unique_address]] FreeArray next_free;
+        [[no_unique_address]] PrevArray prev_free;
+        [[no_unique_address]] FreeBits free_bits;
+        [[no_unique_address]] TagArray tag_masks;
+        [[no_unique_address]] ChangeTickArrays change_ticks;
+
+        // Policy::hooks: destroyed refs are collected here and handed to on_destroy() in batches.
+        using Hooks = typename Policy::hooks;
+        static constexpr bool has_spawn_hook = requires(Hooks& h, std::span<const ThingRef> refs) { h.on_spawn(refs); };
+        static constexpr bool has_destroy_hook = requires(Hooks& h, std::span<const ThingRef> refs) { h.on_destroy(refs); };
+        static constexpr bool has_reset_hook = requires(Hooks& h) { h.on_reset(); };
+        static constexpr ThingIdx hook_batch_size = 64;
+        struct DestroyBatch {
+            ThingRef refs[hook_batch_size];
+            ThingIdx count = 0;
+            // Set while on_destroy() runs; spawning or destroying from inside it would corrupt refs.
+            bool flushing = false;
+        };
+        struct NoDestroyBatch {};
+        [[no_unique_address]] Hooks hooks_;
+        [[no_unique_address]] std::conditional_t<has_destroy_hook, DestroyBatch, NoDestroyBatch> destroyed_batch;
+        union {
+            ThingRef pending_destroy[pending_capacity];
+        };
+        ThingIdx first_free = 0;
+        ThingIdx high_water = 1;
+        ThingIdx constructed = 1;
         ThingIdx pending_destroy_count_ = 0;
+        ThingIdx live_count = 0;
+        ThingIdx retired_slots = 0;
 
-        Node& get_node(ThingRef ref) {
-            if (ref.index == 0 || ref.index >= MAX_THINGS || nodes[ref.index].generation != ref.generation) {
-                return nodes[0]; 
-            }
-            return nodes[ref.index];
-        }
+        // Destroyed slots waiting for pinned readers, bucketed by retire epoch modulo 3.
+        EpochDomain* epoch_domain = nullptr;
+        ThingIdx limbo_head[3] = {};
+        ThingIdx limbo_tail[3] = {};
+        uint64_t limbo_epoch[3] = {};
 
-        void destroy_idx_recursive(ThingIdx idx) {
-            Node& node = nodes[idx];
-            if (!node.is_active) return;
+        // Subtrees invalidated by destroy_incremental(), threaded through reclaim_link() as a DFS stack.
+        ThingIdx reclaim_head = 0;
+        ThingIdx pending_reclaim_ = 0;
 
-            const ThingIdx first_child = node.first_child;
-            if (first_child != 0) {
-                ThingIdx child = first_child;
-                do {
-                    const ThingIdx next_child = nodes[child].next_sibling;
-                    destroy_idx_recursive(child);
-                    child = next_child;
-                } while (child != 0 && child != first_child);
-            }
+        // Bumped by every change to the live set, kinds or hierarchy; never reset.
+        uint64_t structural_version_ = 0;
+        // Bumped by every non-const member, including ones that only hand out T&; never reset.
+        uint64_t write_version_ = 0;
 
-            const ThingRef ref{idx, node.generation};
-            if (node.parent != 0) {
-                detach(ref);
-            }
+        static constexpr uint64_t delta_format_version = 1;
+        static constexpr uint64_t delta_flag_full = 1;
+        static constexpr uint64_t delta_op_spawn = 0;
+        static constexpr uint64_t delta_op_change = 1;
+        static constexpr uint64_t delta_op_destroy = 2;
 
-            const Generation current_gen = node.generation;
-            node = {};
-            node.generation = current_gen;
-            node.is_active = false;
-            next_free[idx] = first_free;
-            first_free = idx;
+        Node& get_node(ThingRef ref) {
+            return const_cast<Node&>(std::as_const(*this).get_node(ref));
         }
 
-    public:
-        ThingPool() {
-            for (ThingIdx i = 1; i < MAX_THINGS - 1; ++i) {
-                next_free[i] = i + 1;
+        // Next free (or limbo) slot after idx. Only meaningful while idx is inactive.
+        ThingIdx& free_link(ThingIdx idx) {
+            if constexpr (Policy::intrusive_free_list) {
+                return nodes[idx].next_sibling;
+            } else {
+                return next_free[idx];
             }
-            next_free[MAX_THINGS - 1] = 0;
         }
 
-        ThingRef spawn() {
-            if (first_free == 0) return NilRef; 
-            ThingIdx idx = first_free;
-            first_free = next_free[idx];
-            Generation new_gen = nodes[idx].generation + 1;
-            nodes[idx] = {}; 
-            nodes[idx].generation = new_gen;
-            nodes[idx].is_active = true;
-            return {idx, new_gen};
+        // Previous slot on the free-list, for O(1) removal by spawn_near(). Policy::locality_bitmap only.
+        ThingIdx& prev_link(ThingIdx idx) {
+            if constexpr (Policy::intrusive_free_list) {
+                return nodes[idx].prev_sibling;
+            } else {
+                return prev_free[idx];
+            }
         }
 
-        void destroy(ThingRef ref) {
-            if (!is_valid(ref)) return;
-            destroy_idx_recursive(ref.index);
+        void set_free_bit(ThingIdx idx) {
+            const size_t word = idx / 64;
+            free_bits.words[word] |= uint64_t{1} << (idx % 64);
+            free_bits.summary[word / 64] |= uint64_t{1} << (word % 64);
         }
 
-        bool destroy_later(ThingRef ref) {
-            if (ref.index == 0) return false;
-            if (pending_destroy_count_ >= (MAX_THINGS - 1)) return false;
-            pending_destroy[pending_destroy_count_++] = ref;
-            return true;
+        void clear_free_bit(ThingIdx idx) {
+            const size_t word = idx / 64;
+            free_bits.words[word] &= ~(uint64_t{1} << (idx % 64));
+            if (free_bits.words[word] == 0) free_bits.summary[word / 64] &= ~(uint64_t{1} << (word % 64));
         }
 
-        size_t flush_destroy_later() {
-            size_t destroyed = 0;
-            const ThingIdx pending_count = pending_destroy_count_;
-            for (ThingIdx i = 0; i < pending_count; ++i) {
-                const ThingRef ref = pending_destroy[i];
-                if (is_valid(ref)) {
-                    destroyed++;
-                }
-                destroy(ref);
+        void push_free(ThingIdx idx) {
+            free_link(idx) = first_free;
+            if constexpr (Policy::locality_bitmap) {
+                prev_link(idx) = 0;
+                if (first_free != 0) prev_link(first_free) = idx;
+                set_free_bit(idx);
             }
-            clear_destroy_later();
-            return destroyed;
+            first_free = idx;
         }
 
-        void clear_destroy_later() {
-            pending_destroy_count_ = 0;
+        ThingIdx pop_free() {
+            const ThingIdx idx = first_free;
+            first_free = free_link(idx);
+            if constexpr (Policy::locality_bitmap) {
+                if (first_free != 0) prev_link(first_free) = 0;
+                clear_free_bit(idx);
+            }
+            return idx;
         }
 
-        size_t pending_destroy_count() const {
-            return pending_destroy_count_;
+        void unlink_free(ThingIdx idx) requires Policy::locality_bitmap {
+            const ThingIdx next = free_link(idx);
+            const ThingIdx prev = prev_link(idx);
+            if (prev != 0) {
+                free_link(prev) = next;
+            } else {
+                first_free = next;
+            }
+            if (next != 0) prev_link(next) = prev;
+            clear_free_bit(idx);
         }
 
-        bool is_valid(ThingRef ref) const {
-            return ref.index > 0 &&
-                   ref.index < MAX_THINGS &&
-                   nodes[ref.index].is_active &&
-                   nodes[ref.index].generation == ref.generation;
+        // Re-derives prev links and bits from the singly-linked free-list, e.g. after a load.
+        void index_free_list() {
+            if constexpr (Policy::locality_bitmap) {
+                const size_t words = (size_t{high_water} + 63) / 64;
+                std::fill_n(free_bits.words, words, uint64_t{0});
+                std::fill_n(free_bits.summary, (words + 63) / 64, uint64_t{0});
+                ThingIdx prev = 0;
+                for (ThingIdx idx = first_free; idx != 0; idx = free_link(idx)) {
+                    prev_link(idx) = prev;
+                    set_free_bit(idx);
+                    prev = idx;
+                }
+            }
         }
 
-        T& get(ThingRef ref) {
-            assert(is_valid(ref) && "ThingPool::get called with invalid ThingRef.");
-            return get_node(ref).data;
+        // Free slot in word closest to hint, or 0. Bits at or above high_water are leftovers of clear().
+        ThingIdx nearest_free_in_word(size_t word, ThingIdx hint) const {
+            uint64_t bits = free_bits.words[word];
+            const size_t first = word * 64;
+            if (first + 64 > high_water) bits &= (uint64_t{1} << (high_water - first)) - 1;
+            if (bits == 0) return 0;
+            if (hint < first) return static_cast<ThingIdx>(first + std::countr_zero(bits));
+            if (hint >= first + 64) return static_cast<ThingIdx>(first + 63 - std::countl_zero(bits));
+            const unsigned bit = hint - first;
+            const uint64_t above = bits & (~uint64_t{0} << bit);
+            const uint64_t below = bits & ((uint64_t{1} << bit) - 1);
+            if (above == 0) return static_cast<ThingIdx>(first + 63 - std::countl_zero(below));
+            const size_t up = first + std::countr_zero(above);
+            if (below == 0) return static_cast<ThingIdx>(up);
+            const size_t down = first + 63 - std::countl_zero(below);
+            return static_cast<ThingIdx>(up - hint <= hint - down ? up : down);
         }
 
-        void attach_child(ThingRef parent_ref, ThingRef child_ref) {
-            Node& parent = get_node(parent_ref);
-            Node& child = get_node(child_ref);
-            if (&parent == &nodes[0] || &child == &nodes[0]) return;
-            
-            if (child.parent != 0) detach(child_ref);
-            child.parent = parent_ref.index;
+        // Takes a free slot in hint's page region: its own bitmap word first, then the other words of
+        // the region, skipping empty ones via the summary bits. Falls back to a fresh slot when the
+        // high-water mark lies in the region. Returns 0 when nothing local is free.
+        ThingIdx take_free_near(ThingIdx hint) {
+            if constexpr (Policy::locality_bitmap) {
+                if (hint == 0 || hint >= high_water) return 0;
+                const size_t word = hint / 64;
+                const size_t region_first = word / locality_region_words * locality_region_words;
+                const size_t region_end = std::min(region_first + locality_region_words, (size_t{high_water} + 63) / 64);
+                const auto take_in_word = [&](size_t candidate) -> ThingIdx {
+                    if (candidate < region_first || candidate >= region_end) return 0;
+                    if ((free_bits.summary[candidate / 64] >> (candidate % 64) & 1) == 0) return 0;
+                    while (const ThingIdx idx = nearest_free_in_word(candidate, hint)) {
+                        unlink_free(idx);
+                        if (nodes[idx].generation < max_generation) return idx;
+                        retired_slots++;
+                    }
+                    return 0;
+                };
+                if (const ThingIdx idx = take_in_word(word)) return idx;
+                for (size_t distance = 1; distance < locality_region_words; ++distance) {
+                    if (const ThingIdx idx = take_in_word(word + distance)) return idx;
+                    if (distance <= word) {
+                        if (const ThingIdx idx = take_in_word(word - distance)) return idx;
+                    }
+                }
+                if (high_water < MAX_THINGS && high_water / 64 / locality_region_words == word / locality_region_words) {
+                    return bump_slot();
+                }
+            }
+            return 0;
+        }
 
-            if (parent.first_child == 0) {
-                parent.first_child = child_ref.index;
-                child.next_sibling = child_ref.index;
-                child.prev_sibling = child_ref.index;
+        // Next slot on the reclaim stack. The intrusive variant uses prev_sibling, because
+        // reclaim_destroyed() still walks next_sibling of stacked nodes.
+        ThingIdx& reclaim_link(ThingIdx idx) {
+            if constexpr (Policy::intrusive_free_list) {
+                return nodes[idx].prev_sibling;
             } else {
-                ThingIdx first_child = parent.first_child;
-                ThingIdx last_child = nodes[first_child].prev_sibling;
-                nodes[last_child].next_sibling = child_ref.index;
-                child.prev_sibling = last_child;
-                child.next_sibling = first_child;
-                nodes[first_child].prev_sibling = child_ref.index;
+                return next_free[idx];
             }
         }
 
-        void detach(ThingRef ref) {
-            Node& node = get_node(ref);
-            if (&node == &nodes[0] || node.parent == 0) return;
-            Node& parent = nodes[node.parent];
+        const Node& get_node(ThingRef ref) const {
+            if (ref.index == 0 || ref.index >= high_water || !nodes[ref.index].is_active ||
+                nodes[ref.index].generation != ref.generation) {
+                return nodes[0]; 
+            }
+            return nodes[ref.index];
+        }
 
-            if (node.next_sibling == ref.index) {
-                parent.first_child = 0;
-            } else {
-                nodes[node.prev_sibling].next_sibling = node.next_sibling;
-                nodes[node.next_sibling].prev_sibling = node.prev_sibling;
-                if (parent.first_child == ref.index) parent.first_child = node.next_sibling;
+        static void clear_links(Node& node) {
+            if constexpr (Policy::hierarchy) {
+                node.parent = 0;
+                node.first_child = 0;
+                node.next_sibling = 0;
+                node.prev_sibling = 0;
             }
+        }
 
-            node.parent = 0;
-            node.next_sibling = 0;
-            node.prev_sibling = 0;
+        void set_slot_tags(ThingIdx idx, TagMask mask) {
+            if constexpr (Policy::tag_bits != 0) tag_masks[idx] = mask;
         }
 
-        // --- Iteration Subsystem ---
-        struct PoolItem {
-            ThingRef ref;
-            T& data;
-        };
+        bool flushing_destroy_hooks() const {
+            if constexpr (has_destroy_hook) return destroyed_batch.flushing;
+            return false;
+        }
 
-        class Iterator {
-            ThingPool* pool;
-            ThingIdx current_idx;
-            void advance_to_next_active() {
-                while (current_idx < MAX_THINGS && !pool->nodes[current_idx].is_active) current_idx++;
-            }
-        public:
-            Iterator(ThingPool* p, ThingIdx start_idx) : pool(p), current_idx(start_idx) {
-                if (current_idx < MAX_THINGS && !pool->nodes[current_idx].is_active) advance_to_next_active();
+        ThingRef notify_spawned(ThingRef ref) {
+            if constexpr (has_spawn_hook) {
+                if (ref) hooks_.on_spawn(std::span<const ThingRef>(&ref, 1));
             }
-            bool operator!=(const Iterator& other) const { return current_idx != other.current_idx; }
-            Iterator& operator++() { current_idx++; advance_to_next_active(); return *this; }
-            PoolItem operator*() { return { ThingRef{current_idx, pool->nodes[current_idx].generation}, pool->nodes[current_idx].data }; }
-        };
-
-        Iterator begin() { return Iterator(this, 1); }
-        Iterator end()   { return Iterator(this, MAX_THINGS); }
+            return ref;
+        }
 
-        template <typename Kind, typename Fn>
-        void for_kind(const Kind& kind, Fn&& fn) {
-            static_assert(
-                requires(T& value, const Kind& query_kind) {
-                    { value.kind == query_kind } -> std::convertible_to<bool>;
-                },
-                "ThingPool::for_kind requires payload T to have a comparable .kind field."
-            );
+        void notify_reset() {
+            if constexpr (has_reset_hook) hooks_.on_reset();
+        }
 
-            for (ThingIdx idx = 1; idx < MAX_THINGS; ++idx) {
-                Node& node = nodes[idx];
-                if (!node.is_active) continue;
-                if (!(node.data.kind == kind)) continue;
-                fn(ThingRef{idx, node.generation}, node.data);
+        // Call while idx still holds the destroyed thing's generation.
+        void note_destroyed(ThingIdx idx) {
+            if constexpr (has_destroy_hook) {
+                assert(!destroyed_batch.flushing && "ThingPool: on_destroy hooks must not destroy things in their own pool.");
+                if (destroyed_batch.count == hook_batch_size) flush_destroy_hooks();
+                destroyed_batch.refs[destroyed_batch.count++] = {idx, nodes[idx].generation};
             }
         }
 
-        template <typename Kind, typename Fn>
-        void for_kind(const Kind& kind, Fn&& fn) const {
-            static_assert(
-                requires(const T& value, const Kind& query_kind) {
-                    { value.kind == query_kind } -> std::convertible_to<bool>;
-                },
-                "ThingPool::for_kind requires payload T to have a comparable .kind field."
-            );
+        void flush_destroy_hooks() {
+            if constexpr (has_destroy_hook) {
+                const ThingIdx count = destroyed_batch.count;
+                destroyed_batch.count = 0;
+                if (count == 0) return;
+                destroyed_batch.flushing = true;
+                hooks_.on_destroy(std::span<const ThingRef>(destroyed_batch.refs, count));
+                destroyed_batch.flushing = false;
+            }
+        }
 
-            for (ThingIdx idx = 1; idx < MAX_THINGS; ++idx) {
-                const Node& node = nodes[idx];
-                if (!node.is_active) continue;
-                if (!(node.data.kind == kind)) continue;
-                fn(ThingRef{idx, node.generation}, node.data);
+        void mark_changed(ThingIdx idx) {
+            if constexpr (Policy::change_ticks) {
+                change_ticks.slots[idx] = change_ticks.current;
+                change_ticks.chunks[idx / 64] = change_ticks.current;
             }
         }
 
-        template <typename Pred>
-        size_t queue_destroy_if(Pred&& pred) {
-            size_t queued = 0;
-            for (ThingIdx idx = 1; idx < MAX_THINGS; ++idx) {
-                Node& node = nodes[idx];
-                if (!node.is_active) continue;
+        // Wire order of the links in delta records. Pools without a hierarchy always send zeros.
+        static void load_links(const Node& node, ThingIdx (&links)[4]) {
+            if constexpr (Policy::hierarchy) {
+                links[0] = node.parent;
+                links[1] = node.first_child;
+                links[2] = node.next_sibling;
+                links[3] = node.prev_sibling;
+            }
+        }
 
-                ThingRef ref{idx, node.generation};
-                if (!pred(ref, node.data)) continue;
-                if (destroy_later(ref)) {
-                    queued++;
+        // load_links() as a client holding only the visible slots sees them: links to slots outside
+        // relevant are dropped and sibling rings skip them, so every sent link names a sent slot.
+        void load_visible_links(ThingIdx idx, const SlotBitmap<MAX_THINGS>& relevant, ThingIdx (&links)[4]) const {
+            if constexpr (Policy::hierarchy) {
+                const auto visible = [&](ThingIdx i) { return slot_active(i) && relevant.test(i); };
+                const Node& node = nodes[idx];
+                if (node.first_child != 0) {
+                    ThingIdx child = node.first_child;
+                    do {
+                        if (visible(child)) {
+                            links[1] = child;
+                            break;
+                        }
+                        child = nodes[child].next_sibling;
+                    } while (child != node.first_child);
                 }
+                // A thing whose parent is hidden arrives as a root. Otherwise idx itself ends both walks.
+                if (node.parent == 0 || !visible(node.parent)) return;
+                links[0] = node.parent;
+                ThingIdx next = node.next_sibling;
+                while (!visible(next)) next = nodes[next].next_sibling;
+                ThingIdx prev = node.prev_sibling;
+                while (!visible(prev)) prev = nodes[prev].prev_sibling;
+                links[2] = next;
+                links[3] = prev;
             }
-            return queued;
         }
 
-        bool save_to_file(const char* filepath) const {
-            static_assert(std::is_trivially_copyable_v<T>, "FATAL: Payload T must be trivially copyable!");
-            SaveHeader header;
-            header.first_free = first_free;
-            
-            return detail::write_pool_to_disk(filepath, &header, sizeof(SaveHeader), 
-                                              next_free, sizeof(next_free), 
-                                              nodes, sizeof(nodes));
+        static void store_links(Node& node, const ThingIdx (&links)[4]) {
+            if constexpr (Policy::hierarchy) {
+                node.parent = links[0];
+                node.first_child = links[1];
+                node.next_sibling = links[2];
+                node.prev_sibling = links[3];
+            }
         }
 
-        bool load_from_file(const char* filepath) {
+        void deactivate_node(Node& node) {
+            set_slot_tags(static_cast<ThingIdx>(&node - nodes), 0);
+            if (epoch_domain != nullptr) {
+                // Pinned readers may still be reading the payload; it is reset when the slot is reused.
+                clear_links(node);
+                std::atomic_ref<bool>(node.is_active).store(false, std::memory_order_release);
+                return;
+            }
+            if constexpr (Policy::scrub == ScrubPolicy::eager) {
+                const Generation current_gen = node.generation;
+                node = {};
+                node.generation = current_gen;
+            } else {
+                clear_links(node);
+                node.is_active = false;
+            }
+        }
+
+        void retire_slot(ThingIdx idx) {
+            if (nodes[idx].generation >= max_generation) {
+                // Exhausted generation: reusing the slot would let stale refs alias the next occupant.
+                retired_slots++;
+                return;
+            }
+            if (epoch_domain == nullptr) {
+                push_free(idx);
+                return;
+            }
+
+            const uint64_t epoch = epoch_domain->epoch();
+            const size_t bag = epoch % 3;
+            // A bag still holding an older epoch is at least 3 epochs old, which is past the grace period.
+            if (limbo_head[bag] != 0 && limbo_epoch[bag] != epoch) release_limbo(bag);
+            limbo_epoch[bag] = epoch;
+            if (limbo_head[bag] == 0) limbo_tail[bag] = idx;
+            free_link(idx) = limbo_head[bag];
+            limbo_head[bag] = idx;
+        }
+
+        void release_limbo(size_t bag) {
+            if constexpr (Policy::locality_bitmap) {
+                ThingIdx prev = 0;
+                for (ThingIdx idx = limbo_head[bag]; idx != 0; idx = free_link(idx)) {
+                    prev_link(idx) = prev;
+                    set_free_bit(idx);
+                    prev = idx;
+                }
+                if (first_free != 0) prev_link(first_free) = limbo_tail[bag];
+            }
+            free_link(limbo_tail[bag]) = first_free;
+            first_free = limbo_head[bag];
+            limbo_head[bag] = 0;
+            limbo_tail[bag] = 0;
+        }
+
+        void clear_limbo() {
+            for (size_t bag = 0; bag < 3; ++bag) {
+                limbo_head[bag] = 0;
+                limbo_tail[bag] = 0;
+            }
+        }
+
+        bool has_limbo() const {
+            return limbo_head[0] != 0 || limbo_head[1] != 0 || limbo_head[2] != 0;
+        }
+
+        // Everything but the nodes, the hooks object and write_version_, for the copy operations.
+        // Per-slot arrays are copied below other.constructed only, which must match constructed.
+        void copy_bookkeeping(const ThingPool& other) {
+            const size_t slots = other.constructed;
+            if constexpr (!Policy::intrusive_free_list) std::copy_n(other.next_free, slots, next_free);
+            if constexpr (Policy::locality_bitmap && !Policy::intrusive_free_list) {
+                std::copy_n(other.prev_free, slots, prev_free);
+            }
+            if constexpr (Policy::locality_bitmap) {
+                std::copy_n(other.free_bits.words, (slots + 63) / 64, free_bits.words);
+                std::copy_n(other.free_bits.summary, (slots + 4095) / 4096, free_bits.summary);
+            }
+            if constexpr (Policy::tag_bits != 0) std::copy_n(other.tag_masks, slots, tag_masks);
+            if constexpr (Policy::change_ticks) {
+                change_ticks.current = other.change_ticks.current;
+                std::copy_n(other.change_ticks.slots, slots, change_ticks.slots);
+                std::copy_n(other.change_ticks.chunks, (slots + 63) / 64, change_ticks.chunks);
+            }
+            if constexpr (has_destroy_hook) destroyed_batch = other.destroyed_batch;
+            std::copy_n(other.pending_destroy, other.pending_destroy_count_, pending_destroy);
+            first_free = other.first_free;
+            high_water = other.high_water;
+            pending_destroy_count_ = other.pending_destroy_count_;
+            live_count = other.live_count;
+            retired_slots = other.retired_slots;
+            epoch_domain = other.epoch_domain;
+            std::copy_n(other.limbo_head, 3, limbo_head);
+            std::copy_n(other.limbo_tail, 3, limbo_tail);
+            std::copy_n(other.limbo_epoch, 3, limbo_epoch);
+            reclaim_head = other.reclaim_head;
+            pending_reclaim_ = other.pending_reclaim_;
+            structural_version_ = other.structural_version_;
+        }
+
+        // Copies the pool's bytes into dst, zero-filled storage the size of a ThingPool. Per-slot
+        // arrays are copied only below `constructed`: the rest is never read, and dst's pages there
+        // are left untouched (and uncommitted).
+        void copy_used_to(void* dst) const {
+            const auto* src = reinterpret_cast<const std::byte*>(this);
+            auto* out = static_cast<std::byte*>(dst);
+            size_t done = 0;
+            // Members are laid out in declaration order; copy up to array, then its used prefix.
+            const auto copy_array = [&](const void* array, size_t used_bytes, size_t array_bytes) {
+                const size_t offset = static_cast<size_t>(static_cast<const std::byte*>(array) - src);
+                std::memcpy(out + done, src + done, offset - done);
+                std::memcpy(out + offset, src + offset, used_bytes);
+                done = offset + array_bytes;
+            };
+            const size_t slots = constructed;
+            copy_array(nodes, slots * sizeof(Node), sizeof(nodes));
+            if constexpr (!Policy::intrusive_free_list) copy_array(next_free, slots * sizeof(ThingIdx), sizeof(next_free));
+            if constexpr (Policy::locality_bitmap && !Policy::intrusive_free_list) {
+                copy_array(prev_free, slots * sizeof(ThingIdx), sizeof(prev_free));
+            }
+            if constexpr (Policy::locality_bitmap) {
+                copy_array(free_bits.words, (slots + 63) / 64 * sizeof(uint64_t), sizeof(free_bits.words));
+                copy_array(free_bits.summary, (slots + 4095) / 4096 * sizeof(uint64_t), sizeof(free_bits.summary));
+            }
+            if constexpr (Policy::tag_bits != 0) copy_array(tag_masks, slots * sizeof(TagMask), sizeof(tag_masks));
+            if constexpr (Policy::change_ticks) {
+                copy_array(change_ticks.slots, slots * sizeof(uint64_t), sizeof(change_ticks.slots));
+                copy_array(change_ticks.chunks, (slots + 63) / 64 * sizeof(uint64_t), sizeof(change_ticks.chunks));
+            }
+            copy_array(pending_destroy, pending_destroy_count_ * sizeof(ThingRef), sizeof(pending_destroy));
+            std::memcpy(out + done, src + done, sizeof(*this) - done);
+        }
+
+        bool slot_active(ThingIdx idx) const { return idx < high_water && nodes[idx].is_active; }
+
+        // Extends the used range to [1, end), constructing slots on first use. Slots left over from
+        // before clear() keep their generation so refs from before the clear stay stale.
+        void grow_high_water(ThingIdx end) {
+            while (high_water < end) {
+                const ThingIdx idx = high_water;
+                if (idx >= constructed) {
+                    std::construct_at(&nodes[idx]);
+                    constructed = idx + 1;
+                    if constexpr (Policy::locality_bitmap) {
+                        // First use of a bitmap word (and of its summary word).
+                        if (idx % 64 == 0) free_bits.words[idx / 64] = 0;
+                        if (idx % 4096 == 0) free_bits.summary[idx / 4096] = 0;
+                    }
+                } else {
+                    nodes[idx].is_active = false;
+                    if constexpr (Policy::locality_bitmap) clear_free_bit(idx);
+                }
+                set_slot_tags(idx, 0);
+                if constexpr (Policy::change_ticks) {
+                    // Gap slots grown past by apply_delta are never stamped; keep their ticks defined.
+                    change_ticks.slots[idx] = 0;
+                    if (idx % 64 == 0) change_ticks.chunks[idx / 64] = 0;
+                }
+                // Release pairs with get_pinned(): readers only look at slots below high_water.
+                std::atomic_ref<ThingIdx>(high_water).store(idx + 1, std::memory_order_release);
+            }
+        }
+
+        // Takes the next never-used slot, retiring any that already reached the generation limit.
+        ThingIdx bump_slot() {
+            while (high_water < MAX_THINGS) {
+                const ThingIdx idx = high_water;
+                grow_high_water(idx + 1);
+                if (nodes[idx].generation < max_generation) return idx;
+                retired_slots++;
+            }
+            return 0;
+        }
+
+        // Pops the free-list, or takes a fresh slot when it is empty. Returns 0 when the pool is full.
+        ThingIdx take_free_slot() {
+            if (first_free == 0 && reclaim_head != 0) reclaim_destroyed(64);
+            // Nothing retired means nothing to collect, so plain bump allocation skips the epoch scan.
+            if (first_free == 0 && has_limbo()) collect_retired();
+            ThingIdx idx = 0;
+            while (idx == 0 && first_free != 0) {
+                idx = pop_free();
+                // Slots loaded or replicated at the generation limit are retired on the way out.
+                if (nodes[idx].generation >= max_generation) {
+                    retired_slots++;
+                    idx = 0;
+                }
+            }
+            // Recycled slots are exhausted; take a fresh one above the high-water mark.
+            return idx != 0 ? idx : bump_slot();
+        }
+
+        static void reset_if_dirty(T& data, bool dirty) {
+            if (dirty) data = T{};
+        }
+
+        // init(data, dirty) writes the payload; dirty means the scrub policy owes a reset to T{}.
+        // hint (0 for none) is a slot the new one should be close to.
+        template <typename Init>
+        ThingRef spawn_impl(ThingIdx hint, Init&& init) {
+            write_version_++;
+            assert(!flushing_destroy_hooks() && "ThingPool: on_destroy hooks must not spawn things in their own pool.");
+            ThingIdx idx = take_free_near(hint);
+            if (idx == 0) idx = take_free_slot();
+            if (idx == 0) return NilRef;
+            live_count++;
+            structural_version_++;
+            Node& node = nodes[idx];
+            const Generation new_gen = node.generation + 1;
+            clear_links(node);
+            // Scrubbing is only owed when the last writer left the payload dirty.
+            init(node.data, Policy::scrub != ScrubPolicy::none && !node.payload_clean);
+            node.payload_clean = false;
+            set_slot_tags(idx, tag_live);
+            mark_changed(idx);
+            // Publish order for get_pinned(): generation first, then is_active.
+            std::atomic_ref<Generation>(node.generation).store(new_gen, std::memory_order_relaxed);
+            std::atomic_ref<bool>(node.is_active).store(true, std::memory_order_release);
+            return {idx, new_gen};
+        }
+
+        void prefetch_scan(ThingIdx idx) const {
+            if constexpr (Policy::scan_prefetch_distance > 0) {
+                if (idx + Policy::scan_prefetch_distance < high_water) {
+                    detail::prefetch(&nodes[idx + Policy::scan_prefetch_distance]);
+                }
+            }
+        }
+
+        void destroy_idx_recursive(ThingIdx idx) {
+            Node& node = nodes[idx];
+            if (!node.is_active) return;
+
+            if constexpr (Policy::hierarchy) {
+                const ThingIdx first_child = node.first_child;
+                if (first_child != 0) {
+                    // A second cursor runs hierarchy_lookahead siblings ahead and prefetches them, so the
+                    // next hops of the chain are in flight while the current child's subtree is destroyed.
+                    ThingIdx ahead = first_child;
+                    for (size_t step = 0; step < Policy::hierarchy_lookahead && ahead != 0; ++step) {
+                        detail::prefetch(&nodes[ahead]);
+                        ahead = nodes[ahead].next_sibling;
+                        if (ahead == first_child) ahead = 0;
+                    }
+
+                    ThingIdx child = first_child;
+                    do {
+                        if constexpr (Policy::hierarchy_lookahead > 0) {
+                            if (ahead != 0) {
+                                detail::prefetch(&nodes[ahead]);
+                                ahead = nodes[ahead].next_sibling;
+                                if (ahead == first_child) ahead = 0;
+                            }
+                            const ThingIdx grandchild = nodes[child].first_child;
+                            if (grandchild != 0) detail::prefetch(&nodes[grandchild]);
+                        }
+                        const ThingIdx next_child = nodes[child].next_sibling;
+                        destroy_idx_recursive(child);
+                        child = next_child;
+                    } while (child != 0 && child != first_child);
+                }
+
+                const ThingRef ref{idx, node.generation};
+                if (node.parent != 0) {
+                    detach(ref);
+                }
+            }
+
+            note_destroyed(idx);
+            deactivate_node(node);
+            live_count--;
+            retire_slot(idx);
+        }
+
+        void recount_stats() {
+            live_count = 0;
+            retired_slots = 0;
+            for (ThingIdx idx = 1; idx < high_water; ++idx) {
+                if (nodes[idx].is_active) {
+                    live_count++;
+                } else if (nodes[idx].generation >= max_generation) {
+                    retired_slots++;
+                }
+            }
+        }
+
+        void clear_reclaim() {
+            reclaim_head = 0;
+            pending_reclaim_ = 0;
+        }
+
+        // Marks every node of a detached subtree inactive without touching links or payloads.
+        // Walks first_child / next_sibling / parent, so it needs no stack.
+        void invalidate_subtree(ThingIdx root) {
+            ThingIdx idx = root;
+            while (true) {
+                Node& node = nodes[idx];
+                if (epoch_domain != nullptr) {
+                    std::atomic_ref<bool>(node.is_active).store(false, std::memory_order_release);
+                } else {
+                    node.is_active = false;
+                }
+                set_slot_tags(idx, 0);
+                note_destroyed(idx);
+                live_count--;
+                pending_reclaim_++;
+
+                if (node.first_child != 0) {
+                    idx = node.first_child;
+                    continue;
+                }
+                while (idx != root) {
+                    const ThingIdx parent = nodes[idx].parent;
+                    const ThingIdx next = nodes[idx].next_sibling;
+                    if (next != nodes[parent].first_child) break;
+                    idx = parent;
+                }
+                if (idx == root) return;
+                idx = nodes[idx].next_sibling;
+            }
+        }
+
+        void push_reclaim(ThingIdx idx) {
+            reclaim_link(idx) = reclaim_head;
+            reclaim_head = idx;
+        }
+
+        // Appends root's subtree to sequence in depth-first pre-order, without a stack.
+        ThingIdx append_subtree(ThingIdx root, ThingIdx* sequence, ThingIdx count) const {
+            ThingIdx idx = root;
+            while (true) {
+                sequence[count++] = idx;
+                if (nodes[idx].first_child != 0) {
+                    idx = nodes[idx].first_child;
+                    continue;
+                }
+                while (idx != root) {
+                    const ThingIdx parent = nodes[idx].parent;
+                    if (nodes[idx].next_sibling != nodes[parent].first_child) break;
+                    idx = parent;
+                }
+                if (idx == root) return count;
+                idx = nodes[idx].next_sibling;
+            }
+        }
+
+        // Moves the live slots listed in sequence to the lowest usable slots, in that order. A slot
+        // that receives a different node bumps its generation, so every old ref into it goes stale.
+        // scratch holds 3 * high_water entries.
+        bool permute_live(const ThingIdx* sequence, ThingIdx count, ThingIdx* scratch, std::span<RefRemap> remap) {
+            ThingIdx* dest = scratch;
+            ThingIdx* placed = scratch + high_water;
+            Generation* old_generation = scratch + 2 * size_t{high_water};
+            for (ThingIdx idx = 0; idx < high_water; ++idx) {
+                old_generation[idx] = nodes[idx].generation;
+                placed[idx] = 0;
+            }
+
+            ThingIdx target = 1;
+            for (ThingIdx i = 0; i < count; ++i) {
+                const ThingIdx src = sequence[i];
+                // Slots at the generation limit cannot take a new occupant.
+                while (target < high_water && target != src && old_generation[target] >= max_generation) target++;
+                if (target >= high_water) return false;
+                dest[src] = target;
+                placed[target++] = src;
+            }
+            // Dead slots fill the positions nobody was placed in.
+            ThingIdx free_pos = 1;
+            for (ThingIdx idx = 1; idx < high_water; ++idx) {
+                if (nodes[idx].is_active) continue;
+                while (placed[free_pos] != 0) free_pos++;
+                dest[idx] = free_pos++;
+            }
+
+            std::fill(remap.begin(), remap.end(), RefRemap{});
+            for (ThingIdx i = 0; i < count; ++i) {
+                const ThingIdx src = sequence[i];
+                const ThingIdx to = dest[src];
+                const Generation generation = to == src ? old_generation[src] : old_generation[to] + 1;
+                remap[src] = {old_generation[src], ThingRef{to, generation}};
+            }
+
+            // Cycle-following permutation: every swap puts one node in its final slot.
+            for (ThingIdx idx = 1; idx < high_water; ++idx) {
+                while (dest[idx] != idx) {
+                    const ThingIdx to = dest[idx];
+                    std::swap(nodes[idx], nodes[to]);
+                    if constexpr (Policy::tag_bits != 0) std::swap(tag_masks[idx], tag_masks[to]);
+                    if constexpr (Policy::change_ticks) std::swap(change_ticks.slots[idx], change_ticks.slots[to]);
+                    std::swap(dest[idx], dest[to]);
+                }
+            }
+            if constexpr (Policy::change_ticks) {
+                // Moving a thing is not a change; chunk ticks are rebuilt from the moved slot ticks.
+                std::fill_n(change_ticks.chunks, (high_water + 63) / 64, uint64_t{0});
+                for (ThingIdx idx = 1; idx < high_water; ++idx) {
+                    uint64_t& chunk = change_ticks.chunks[idx / 64];
+                    chunk = std::max(chunk, change_ticks.slots[idx]);
+                }
+            }
+
+            const auto moved = [&](ThingIdx link) { return link == 0 ? ThingIdx{0} : remap[link].new_ref.index; };
+            for (ThingIdx idx = 1; idx < high_water; ++idx) {
+                Node& node = nodes[idx];
+                if (placed[idx] != 0) {
+                    node.generation = remap[placed[idx]].new_ref.generation;
+                    if constexpr (Policy::hierarchy) {
+                        node.parent = moved(node.parent);
+                        node.first_child = moved(node.first_child);
+                        node.next_sibling = moved(node.next_sibling);
+                        node.prev_sibling = moved(node.prev_sibling);
+                    }
+                } else {
+                    // A vacated slot keeps its own generation history.
+                    node.generation = old_generation[idx];
+                    node.is_active = false;
+                    node.payload_clean = false;
+                    clear_links(node);
+                    set_slot_tags(idx, 0);
+                }
+            }
+
+            for (ThingIdx i = 0; i < pending_destroy_count_; ++i) {
+                pending_destroy[i] = remap_ref(remap, pending_destroy[i]);
+            }
+            // Slots above the last placed node are only dead ones; scans can stop earlier. They keep
+            // their generations, like slots left behind by clear().
+            high_water = target;
+            rebuild_free_list();
+            return true;
+        }
+
+        // Stages each table's section in turn; the innermost call commits the pool, then every table
+        // commits on the way back out.
+        template <typename Commit>
+        static bool load_tables(const char*, size_t, Commit& commit) {
+            return commit();
+        }
+
+        template <typename Commit, typename Table, typename... Rest>
+        static bool load_tables(const char* filepath, size_t offset, Commit& commit, Table& table, Rest&... rest) {
+            return table.load_section(filepath, offset, [&](size_t next_offset) {
+                return load_tables(filepath, next_offset, commit, rest...);
+            });
+        }
+
+        void rebuild_free_list() {
+            clear_limbo();
+            clear_reclaim();
+            first_free = 0;
+            for (ThingIdx idx = high_water - 1; idx > 0; --idx) {
+                if (nodes[idx].is_active || nodes[idx].generation >= max_generation) continue;
+                free_link(idx) = first_free;
+                first_free = idx;
+            }
+            index_free_list();
+            recount_stats();
+        }
+
+        static void write_delta_record(detail::ByteWriter& out, ThingIdx idx, ThingIdx& previous, uint64_t op) {
+            detail::write_varint(out, (uint64_t{idx - previous} << 2) | op);
+            previous = idx;
+        }
+
+        static constexpr bool gather_friendly =
+            MAX_THINGS * sizeof(Node) <= size_t{0x7FFFFFFF} && sizeof(Node) % sizeof(uint32_t) == 0;
+
+        void prefetch_ref(std::span<const ThingRef> refs, size_t i) const {
+            if (i >= refs.size()) return;
+            const ThingIdx idx = refs[i].index;
+            if (idx < high_water) detail::prefetch(&nodes[idx]);
+        }
+
+#if defined(__AVX2__)
+        // Checks 8 refs with two gathers (generation and is_active) instead of 8 dependent loads.
+        uint32_t validate8(const ThingRef* refs) const {
+            const __m256 lo = _mm256_castsi256_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(refs)));
+            const __m256 hi = _mm256_castsi256_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(refs + 4)));
+            const __m256i idx = _mm256_permute4x64_epi64(
+                _mm256_castps_si256(_mm256_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0))), _MM_SHUFFLE(3, 1, 2, 0));
+            const __m256i gen = _mm256_permute4x64_epi64(
+                _mm256_castps_si256(_mm256_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1))), _MM_SHUFFLE(3, 1, 2, 0));
+
+            const __m256i zero = _mm256_setzero_si256();
+            const __m256i in_range = _mm256_and_si256(
+                _mm256_cmpgt_epi32(idx, zero),
+                _mm256_cmpgt_epi32(_mm256_set1_epi32(static_cast<int>(high_water)), idx));
+            const __m256i offsets = _mm256_mullo_epi32(_mm256_and_si256(idx, in_range),
+                                                       _mm256_set1_epi32(static_cast<int>(sizeof(Node))));
+
+            // is_active is gathered as a 32-bit word and masked down to its byte.
+            const auto* gen_base = reinterpret_cast<const int*>(&nodes[0].generation);
+            const auto* active_base = reinterpret_cast<const int*>(&nodes[0].is_active);
+            const __m256i node_gen = _mm256_i32gather_epi32(gen_base, offsets, 1);
+            const __m256i node_active = _mm256_and_si256(_mm256_i32gather_epi32(active_base, offsets, 1),
+                                                         _mm256_set1_epi32(0xFF));
+
+            const __m256i valid = _mm256_andnot_si256(
+                _mm256_cmpeq_epi32(node_active, zero),
+                _mm256_and_si256(in_range, _mm256_cmpeq_epi32(node_gen, gen)));
+            return static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(valid)));
+        }
+#endif
+
+        uint64_t validate_block(std::span<const ThingRef> refs, size_t first, size_t count) const {
+            constexpr size_t ahead = Policy::batch_prefetch_distance;
+            uint64_t mask = 0;
+            size_t i = 0;
+#if defined(__AVX2__)
+            if constexpr (gather_friendly) {
+                for (; i + 8 <= count; i += 8) {
+                    for (size_t p = 0; p < 8; ++p) prefetch_ref(refs, first + i + ahead + p);
+                    mask |= uint64_t{validate8(refs.data() + first + i)} << i;
+                }
+            }
+#endif
+            for (; i < count; ++i) {
+                prefetch_ref(refs, first + i + ahead);
+                if (is_valid(refs[first + i])) mask |= uint64_t{1} << i;
+            }
+            return mask;
+        }
+
+        // Walks [first, last) like for_kind() until stop(visited, scanned) says so. stop is asked after
+        // each call to fn and every 64 scanned slots, so sparse kinds still end the walk on budget.
+        // Returns the index to resume at.
+        template <typename Self, typename Kind, typename Fn, typename Stop>
+        static ThingIdx for_kind_range(Self& self, const Kind& kind, ThingIdx first, ThingIdx last, Fn& fn,
+                                       size_t& visited, size_t& scanned, Stop& stop) {
+            static_assert(
+                requires(const T& value, const Kind& query_kind) {
+                    { value.kind == query_kind } -> std::convertible_to<bool>;
+                },
+                "ThingPool::for_kind requires payload T to have a comparable .kind field."
+            );
+
+            for (ThingIdx idx = first; idx < last; ++idx) {
+                self.prefetch_scan(idx);
+                auto& node = self.nodes[idx];
+                const bool hit = node.is_active && node.data.kind == kind;
+                if (hit) {
+                    fn(ThingRef{idx, node.generation}, node.data);
+                    visited++;
+                }
+                if ((hit || ++scanned % 64 == 0) && stop(visited, scanned)) return idx + 1;
+            }
+            return last;
+        }
+
+        template <typename Self, typename Kind, typename Fn>
+        static size_t for_kind_sliced_impl(Self& self, const Kind& kind, size_t slice_count, uint64_t frame_index, Fn& fn) {
+            assert(slice_count > 0 && "ThingPool::for_kind_sliced requires slice_count > 0.");
+            // Slices cover the used range, so a lightly filled pool still spreads its work evenly.
+            const size_t used = self.high_water - 1;
+            const size_t slice_len = (used + slice_count - 1) / slice_count;
+            const size_t first = 1 + static_cast<size_t>(frame_index % slice_count) * slice_len;
+            if (first >= self.high_water) return 0;
+            const size_t last = std::min<size_t>(self.high_water, first + slice_len);
+            size_t visited = 0;
+            size_t scanned = 0;
+            auto never = [](size_t, size_t) { return false; };
+            for_kind_range(self, kind, static_cast<ThingIdx>(first), static_cast<ThingIdx>(last), fn, visited, scanned, never);
+            return visited;
+        }
+
+        static auto visit_budget(size_t max_visits) {
+            return [max_visits](size_t visited, size_t scanned) {
+                return visited >= max_visits || scanned / budget_scan_per_visit >= max_visits;
+            };
+        }
+
+        static auto time_budget(std::chrono::nanoseconds max_time) {
+            const auto deadline = std::chrono::steady_clock::now() + max_time;
+            return [deadline](size_t, size_t) { return std::chrono::steady_clock::now() >= deadline; };
+        }
+
+        template <typename Self, typename Kind, typename Fn, typename Stop>
+        static size_t for_kind_budget_impl(Self& self, const Kind& kind, PassCursor& cursor, Fn& fn, Stop stop) {
+            const ThingIdx end = self.high_water;
+            if (cursor.next == 0 || cursor.next >= end) cursor.next = 1;
+            const ThingIdx start = cursor.next;
+            size_t visited = 0;
+            size_t scanned = 0;
+            if (stop(visited, scanned)) return 0;
+
+            // At most one lap: [start, high_water) then [1, start).
+            ThingIdx resume = for_kind_range(self, kind, start, end, fn, visited, scanned, stop);
+            if (resume == end) {
+                cursor.passes++;
+                resume = 1;
+                if (start > 1 && !stop(visited, scanned)) {
+                    resume = for_kind_range(self, kind, 1, start, fn, visited, scanned, stop);
+                }
+            }
+            cursor.next = resume;
+            return visited;
+        }
+
+        // Bit i set when slot first + i has every required bit and no rejected one.
+        uint32_t match_tags(ThingIdx first, ThingIdx count, TagMask required, TagMask rejected) const {
+            uint32_t matches = 0;
+            for (ThingIdx i = 0; i < count; ++i) {
+                const TagMask mask = tag_masks[first + i];
+                matches |= uint32_t{(mask & required) == required && (mask & rejected) == 0} << i;
+            }
+            return matches;
+        }
+
+#if defined(__AVX2__)
+        uint32_t match_tags8(ThingIdx first, TagMask required, TagMask rejected) const {
+            const auto* masks = reinterpret_cast<const __m256i*>(tag_masks + first);
+            if constexpr (sizeof(TagMask) == sizeof(uint32_t)) {
+                const __m256i req = _mm256_set1_epi32(static_cast<int>(required));
+                const __m256i rej = _mm256_set1_epi32(static_cast<int>(rejected));
+                const __m256i lanes = _mm256_loadu_si256(masks);
+                const __m256i match = _mm256_and_si256(
+                    _mm256_cmpeq_epi32(_mm256_and_si256(lanes, req), req),
+                    _mm256_cmpeq_epi32(_mm256_and_si256(lanes, rej), _mm256_setzero_si256()));
+                return static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(match)));
+            } else {
+                const __m256i req = _mm256_set1_epi64x(static_cast<long long>(required));
+                const __m256i rej = _mm256_set1_epi64x(static_cast<long long>(rejected));
+                uint32_t matches = 0;
+                for (int half = 0; half < 2; ++half) {
+                    const __m256i lanes = _mm256_loadu_si256(masks + half);
+                    const __m256i match = _mm256_and_si256(
+                        _mm256_cmpeq_epi64(_mm256_and_si256(lanes, req), req),
+                        _mm256_cmpeq_epi64(_mm256_and_si256(lanes, rej), _mm256_setzero_si256()));
+                    matches |= static_cast<uint32_t>(_mm256_movemask_pd(_mm256_castsi256_pd(match))) << (4 * half);
+                }
+                return matches;
+            }
+        }
+#endif
+
+        template <typename Self, typename Fn>
+        static void for_changed_since_impl(Self& self, uint64_t tick, Fn& fn) {
+            const ThingIdx end = self.high_water;
+            for (ThingIdx first = 0; first < end; first += 64) {
+                if (self.change_ticks.chunks[first / 64] <= tick) continue;
+                const ThingIdx last = std::min<ThingIdx>(first + 64, end);
+                for (ThingIdx idx = std::max<ThingIdx>(first, 1); idx < last; ++idx) {
+                    auto& node = self.nodes[idx];
+                    if (!node.is_active || self.change_ticks.slots[idx] <= tick) continue;
+                    fn(ThingRef{idx, node.generation}, node.data);
+                }
+            }
+        }
+
+        // Filters 8 slots per step on the dense tag array and only touches nodes that match.
+        template <typename Self, typename Fn>
+        static void for_tags_impl(Self& self, TagMask all_of, TagMask none_of, Fn& fn) {
+            const TagMask required = (all_of & user_tags) | tag_live;
+            const TagMask rejected = none_of & user_tags;
+            for (ThingIdx first = 0; first < self.high_water; first += 8) {
+                const ThingIdx count = std::min<ThingIdx>(8, self.high_water - first);
+                uint32_t matches = 0;
+#if defined(__AVX2__)
+                if (count == 8) {
+                    matches = self.match_tags8(first, required, rejected);
+                } else {
+                    matches = self.match_tags(first, count, required, rejected);
+                }
+#else
+                matches = self.match_tags(first, count, required, rejected);
+#endif
+                for (; matches != 0; matches &= matches - 1) {
+                    const ThingIdx idx = first + static_cast<ThingIdx>(std::countr_zero(matches));
+                    // fn may have retagged or destroyed later slots of this group.
+                    if (self.match_tags(idx, 1, required, rejected) == 0) continue;
+                    auto& node = self.nodes[idx];
+                    fn(ThingRef{idx, node.generation}, node.data);
+                }
+            }
+        }
+
+        template <typename Self, typename Fn>
+        static void for_each_chunk_impl(Self& self, Fn& fn) {
+            using ChunkType = std::conditional_t<std::is_const_v<Self>, ConstChunk, Chunk>;
+            for (size_t first = 0; first < self.high_water; first += 64) {
+                const uint32_t count = static_cast<uint32_t>(std::min<size_t>(64, self.high_water - first));
+                auto* slots = &self.nodes[first];
+                uint64_t active = 0;
+                for (uint32_t i = 0; i < count; ++i) {
+                    active |= uint64_t{slots[i].is_active} << i;
+                }
+                if (active == 0) continue;
+                fn(ChunkType(slots, static_cast<ThingIdx>(first), count, active));
+            }
+        }
+
+        template <typename Self, typename Out>
+        static size_t resolve_batch_impl(Self& self, std::span<const ThingRef> refs, std::span<Out*> out) {
+            assert(out.size() >= refs.size() && "ThingPool::resolve_batch output span is too small.");
+            size_t resolved = 0;
+            for (size_t first = 0; first < refs.size(); first += 64) {
+                const size_t count = std::min<size_t>(64, refs.size() - first);
+                const uint64_t mask = self.validate_block(refs, first, count);
+                for (size_t i = 0; i < count; ++i) {
+                    const bool valid = (mask >> i) & 1;
+                    out[first + i] = valid ? &self.nodes[refs[first + i].index].data : nullptr;
+                }
+                resolved += static_cast<size_t>(std::popcount(mask));
+            }
+            return resolved;
+        }
+
+        size_t encode_delta_impl(ReplicationBaseline<T, MAX_THINGS>& baseline, std::span<uint8_t> out,
+                                 const SlotBitmap<MAX_THINGS>* relevant) const {
+            static_assert(std::is_trivially_copyable_v<T>, "FATAL: Payload T must be trivially copyable!");
+            detail::ByteWriter writer{out.data(), out.size()};
+            const bool full = baseline.full_resync;
+            if (full) baseline.active.clear();
+            detail::write_varint(writer, delta_format_version);
+            detail::write_varint(writer, full ? delta_flag_full : 0);
+
+            ThingIdx previous = 0;
+            auto encode_slot = [&](ThingIdx idx, bool visible) {
+                const Node& node = nodes[idx];
+                auto& base = baseline.slots[idx];
+                const bool was_active = baseline.active.test(idx);
+
+                if (!visible) {
+                    if (!was_active) return;
+                    write_delta_record(writer, idx, previous, delta_op_destroy);
+                    baseline.active.reset(idx);
+                    return;
+                }
+
+                ThingIdx links[4] = {};
+                if (relevant == nullptr) {
+                    load_links(node, links);
+                } else {
+                    load_visible_links(idx, *relevant, links);
+                }
+                if (!was_active || base.generation != node.generation) {
+                    write_delta_record(writer, idx, previous, delta_op_spawn);
+                    detail::write_varint(writer, node.generation);
+                    detail::write_xor_runs(writer, links, nullptr, sizeof(links));
+                    detail::write_xor_runs(writer, &node.data, nullptr, sizeof(T));
+                } else {
+                    if (std::memcmp(links, base.links, sizeof(links)) == 0 &&
+                        std::memcmp(&node.data, &base.data, sizeof(T)) == 0) return;
+                    write_delta_record(writer, idx, previous, delta_op_change);
+                    detail::write_xor_runs(writer, links, base.links, sizeof(links));
+                    detail::write_xor_runs(writer, &node.data, &base.data, sizeof(T));
+                }
+
+                base.generation = node.generation;
+                baseline.active.set(idx);
+                std::memcpy(base.links, links, sizeof(links));
+                std::memcpy(&base.data, &node.data, sizeof(T));
+            };
+
+            if (relevant == nullptr) {
+                for (ThingIdx idx = 1; idx < MAX_THINGS && !writer.overflow; ++idx) {
+                    encode_slot(idx, slot_active(idx));
+                }
+            } else {
+                // Only slots the client may hold or should receive are visited.
+                for (size_t w = 0; w < SlotBitmap<MAX_THINGS>::word_count && !writer.overflow; ++w) {
+                    for (uint64_t bits = relevant->word(w) | baseline.active.word(w); bits != 0; bits &= bits - 1) {
+                        const auto idx = static_cast<ThingIdx>(w * 64 + static_cast<size_t>(std::countr_zero(bits)));
+                        if (idx == 0) continue;
+                        encode_slot(idx, slot_active(idx) && relevant->test(idx));
+                    }
+                }
+            }
+            detail::write_varint(writer, 0);
+
+            if (writer.overflow) {
+                baseline.reset();
+                return 0;
+            }
+            baseline.full_resync = false;
+            return writer.size;
+        }
+
+        bool decode_delta(std::span<const uint8_t> delta, bool apply) {
+            detail::ByteReader in{delta.data(), delta.size()};
+            uint64_t version = 0;
+            uint64_t flags = 0;
+            if (!detail::read_varint(in, version) || version != delta_format_version) return false;
+            if (!detail::read_varint(in, flags) || (flags & ~delta_flag_full) != 0) return false;
+            const bool full = (flags & delta_flag_full) != 0;
+
+            if (apply && full) {
+                for (ThingIdx idx = 1; idx < high_water; ++idx) {
+                    if (nodes[idx].is_active) deactivate_node(nodes[idx]);
+                }
+            }
+
+            ThingIdx previous = 0;
+            for (;;) {
+                uint64_t tag = 0;
+                if (!detail::read_varint(in, tag)) return false;
+                if (tag == 0) break;
+
+                const uint64_t op = tag & 3;
+                const uint64_t step = tag >> 2;
+                if (step == 0 || step >= MAX_THINGS - previous) return false;
+                const ThingIdx idx = previous + static_cast<ThingIdx>(step);
+                previous = idx;
+
+                const bool was_active = !full && slot_active(idx);
+                if (apply && op == delta_op_spawn) grow_high_water(idx + 1);
+                Node& node = nodes[idx];
+                ThingIdx links[4] = {};
+
+                if (op == delta_op_spawn) {
+                    uint64_t generation = 0;
+                    if (!detail::read_varint(in, generation)) return false;
+                    if (generation == 0 || generation > max_generation) return false;
+                    if (!detail::read_xor_runs(in, links, sizeof(links))) return false;
+                    if (apply) {
+                        node = {};
+                        node.generation = static_cast<Generation>(generation);
+                        node.is_active = true;
+                        node.payload_clean = false;
+                        set_slot_tags(idx, tag_live);
+                        mark_changed(idx);
+                    }
+                    if (!detail::read_xor_runs(in, apply ? &node.data : nullptr, sizeof(T))) return false;
+                } else if (op == delta_op_change) {
+                    if (!was_active) return false;
+                    load_links(node, links);
+                    if (!detail::read_xor_runs(in, links, sizeof(links))) return false;
+                    if (!detail::read_xor_runs(in, apply ? &node.data : nullptr, sizeof(T))) return false;
+                    if (apply) mark_changed(idx);
+                } else if (op == delta_op_destroy) {
+                    if (!was_active) return false;
+                    if (apply) deactivate_node(node);
+                    continue;
+                } else {
+                    return false;
+                }
+
+                for (const ThingIdx link : links) {
+                    if (link >= MAX_THINGS || (!Policy::hierarchy && link != 0)) return false;
+                }
+                if (apply) store_links(node, links);
+            }
+            return in.offset == in.size;
+        }
+
+    public:
+        // O(1): only the nil slot is constructed up front.
+        ThingPool() {
+            std::construct_at(&nodes[0]);
+            set_slot_tags(0, 0);
+            if constexpr (Policy::change_ticks) {
+                change_ticks.slots[0] = 0;
+                change_ticks.chunks[0] = 0;
+            }
+            if constexpr (Policy::locality_bitmap) {
+                free_bits.words[0] = 0;
+                free_bits.summary[0] = 0;
+            }
+        }
+
+        // Copies slots [0, other.constructed) and the bookkeeping. Storage above is left untouched,
+        // as in a new pool.
+        ThingPool(const ThingPool& other) : hooks_(other.hooks_) {
+            std::uninitialized_copy_n(other.nodes, other.constructed, nodes);
+            constructed = other.constructed;
+            copy_bookkeeping(other);
+            write_version_ = other.write_version_;
+        }
+
+        ThingPool& operator=(const ThingPool& other) {
+            if (this == &other) return *this;
+            const ThingIdx shared = std::min(constructed, other.constructed);
+            std::copy_n(other.nodes, shared, nodes);
+            if (other.constructed > shared) {
+                std::uninitialized_copy(other.nodes + shared, other.nodes + other.constructed, nodes + shared);
+            } else {
+                std::destroy(nodes + other.constructed, nodes + constructed);
+            }
+            constructed = other.constructed;
+            hooks_ = other.hooks_;
+            // Versions move past both pools' so nothing cached from either looks current.
+            const uint64_t structural = std::max(structural_version_, other.structural_version_) + 1;
+            const uint64_t written = std::max(write_version_, other.write_version_) + 1;
+            copy_bookkeeping(other);
+            structural_version_ = structural;
+            write_version_ = written;
+            return *this;
+        }
+
+        ~ThingPool() requires std::is_trivially_destructible_v<T> = default;
+        ~ThingPool() {
+            for (ThingIdx idx = 0; idx < constructed; ++idx) std::destroy_at(&nodes[idx]);
+        }
+
+        ThingRef spawn() {
+            return notify_spawned(spawn_impl(0, reset_if_dirty));
+        }
+
+        // Spawns up to out.size() things into out and returns how many fit; the rest of out is set
+        // to NilRef. on_spawn hooks see the whole batch in one call.
+        size_t spawn_n(std::span<ThingRef> out) {
+            size_t spawned = 0;
+            while (spawned < out.size()) {
+                const ThingRef ref = spawn_impl(0, reset_if_dirty);
+                if (!ref) break;
+                out[spawned++] = ref;
+            }
+            std::fill(out.begin() + static_cast<std::ptrdiff_t>(spawned), out.end(), NilRef);
+            if constexpr (has_spawn_hook) {
+                if (spawned != 0) hooks_.on_spawn(std::span<const ThingRef>(out.data(), spawned));
+            }
+            return spawned;
+        }
+
+        // Prefers a free slot in the same bitmap word, then page, as hint (Policy::locality_bitmap).
+        // Otherwise, and for pools without the bitmap, behaves like spawn(). Only hint.index is used.
+        ThingRef spawn_near(ThingRef hint) {
+            return notify_spawned(spawn_impl(hint.index, reset_if_dirty));
+        }
+
+        // Spawns a child of parent, placed next to its last child (or parent itself) and attached
+        // as the last child. Returns NilRef if parent is invalid or the pool is full.
+        ThingRef spawn_child(ThingRef parent) requires Policy::hierarchy {
+            if (!is_valid(parent)) return NilRef;
+            const Node& parent_node = nodes[parent.index];
+            const ThingIdx hint = parent_node.first_child != 0 ? nodes[parent_node.first_child].prev_sibling : parent.index;
+            const ThingRef child = spawn_impl(hint, reset_if_dirty);
+            if (child) attach_child(parent, child);
+            return notify_spawned(child);
+        }
+
+        // Spawns with the payload copied from value; the slot is written once, whatever the scrub policy.
+        ThingRef spawn_with(const T& value) {
+            return notify_spawned(spawn_impl(0, [&](T& data, bool) { data = value; }));
+        }
+
+        // Spawns and lets fn initialize the payload in place. fn sees T{} unless the policy is
+        // ScrubPolicy::none, in which case it sees the previous occupant's bytes.
+        template <typename Fn>
+            requires std::invocable<Fn&, T&>
+        ThingRef spawn_with(Fn&& fn) {
+            return notify_spawned(spawn_impl(0, [&](T& data, bool dirty) {
+                reset_if_dirty(data, dirty);
+                fn(data);
+            }));
+        }
+
+        void destroy(ThingRef ref) {
+            write_version_++;
+            if (!is_valid(ref)) return;
+            structural_version_++;
+            destroy_idx_recursive(ref.index);
+            flush_destroy_hooks();
+        }
+
+        // Detaches ref and invalidates its whole subtree now (one flag store per node), but leaves
+        // clearing and freeing the slots to reclaim_destroyed(). Without a hierarchy this is destroy().
+        void destroy_incremental(ThingRef ref) {
+            write_version_++;
+            if (!is_valid(ref)) return;
+            structural_version_++;
+            if constexpr (Policy::hierarchy) {
+                detach(ref);
+                invalidate_subtree(ref.index);
+                push_reclaim(ref.index);
+            } else {
+                destroy_idx_recursive(ref.index);
+            }
+            flush_destroy_hooks();
+        }
+
+        // Frees up to max_nodes slots invalidated by destroy_incremental(). Returns the number freed.
+        size_t reclaim_destroyed(size_t max_nodes) {
+            write_version_++;
+            size_t reclaimed = 0;
+            if constexpr (Policy::hierarchy) {
+                while (reclaim_head != 0 && reclaimed < max_nodes) {
+                    const ThingIdx idx = reclaim_head;
+                    Node& node = nodes[idx];
+                    reclaim_head = reclaim_link(idx);
+
+                    // Siblings are pushed one at a time; cutting the ring keeps each step O(1).
+                    if (node.next_sibling != 0) push_reclaim(node.next_sibling);
+                    if (node.first_child != 0) {
+                        nodes[nodes[node.first_child].prev_sibling].next_sibling = 0;
+                        push_reclaim(node.first_child);
+                    }
+
+                    deactivate_node(node);
+                    retire_slot(idx);
+                    pending_reclaim_--;
+                    reclaimed++;
+                }
+            }
+            return reclaimed;
+        }
+
+        bool destroy_later(ThingRef ref) {
+            write_version_++;
+            if (ref.index == 0) return false;
+            if (pending_destroy_count_ >= pending_capacity) return false;
+            pending_destroy[pending_destroy_count_++] = ref;
+            return true;
+        }
+
+        size_t flush_destroy_later() {
+            write_version_++;
+            size_t destroyed = 0;
+            const ThingIdx pending_count = pending_destroy_count_;
+            for (ThingIdx i = 0; i < pending_count; ++i) {
+                const ThingRef ref = pending_destroy[i];
+                if (!is_valid(ref)) continue;
+                destroyed++;
+                structural_version_++;
+                destroy_idx_recursive(ref.index);
+            }
+            // One on_destroy batch for the whole queue rather than one per ref.
+            flush_destroy_hooks();
+            clear_destroy_later();
+            return destroyed;
+        }
+
+        void clear_destroy_later() {
+            write_version_++;
+            pending_destroy_count_ = 0;
+        }
+
+        size_t pending_destroy_count() const {
+            return pending_destroy_count_;
+        }
+
+        PoolStats stats() const {
+            return {live_count, retired_slots, pending_reclaim_};
+        }
+
+        // O(1): forgets every slot and queue. Refs from before the clear stay invalid. Requires no
+        // pinned readers when an epoch domain is attached. Calls on_reset() hooks, not on_destroy().
+        void clear() {
+            write_version_++;
+            assert(!flushing_destroy_hooks() && "ThingPool: on_destroy hooks must not clear their own pool.");
+            first_free = 0;
+            high_water = 1;
+            live_count = 0;
+            structural_version_++;
+            retired_slots = 0;
+            clear_destroy_later();
+            clear_limbo();
+            clear_reclaim();
+            notify_reset();
+        }
+
+        // Permutes live slots into the lowest slots in the given order and writes remap[old index]
+        // for every slot below the old high-water mark. Refs held by the caller (including ones
+        // inside payloads) must be passed through remap_ref(). O(high_water); meant for loading
+        // screens. Requires no pinned readers. Returns false, changing nothing, if remap is smaller
+        // than high_water_mark(), T has no ordered .kind for by_kind, scratch cannot be allocated, or
+        // slots at max_generation (common with a small Policy::generation_bits) leave a live thing
+        // no slot to move to. On success, on_reset() hooks run once the slots have moved.
+        bool reorder(ReorderPolicy order, std::span<RefRemap> remap) {
+            write_version_++;
+            if (remap.size() < high_water) return false;
+            // Scratch is sized by high_water and lives on the heap: large pools would overflow the stack.
+            const std::unique_ptr<ThingIdx[]> scratch(new (std::nothrow) ThingIdx[4 * size_t{high_water}]);
+            if (!scratch) return false;
+            ThingIdx* sequence = scratch.get();
+            ThingIdx count = 0;
+            for (ThingIdx idx = 1; idx < high_water; ++idx) {
+                if (!nodes[idx].is_active) continue;
+                if constexpr (Policy::hierarchy) {
+                    if (order == ReorderPolicy::hierarchy_dfs) {
+                        if (nodes[idx].parent == 0) count = append_subtree(idx, sequence, count);
+                        continue;
+                    }
+                }
+                sequence[count++] = idx;
+            }
+            if (order == ReorderPolicy::by_kind) {
+                if constexpr (requires(const T& a) { a.kind < a.kind; }) {
+                    std::stable_sort(sequence, sequence + count, [&](ThingIdx a, ThingIdx b) {
+                        return nodes[a].data.kind < nodes[b].data.kind;
+                    });
+                } else {
+                    return false;
+                }
+            }
+            if (!permute_live(sequence, count, sequence + high_water, remap)) return false;
+            structural_version_++;
+            notify_reset();
+            return true;
+        }
+
+        // One past the highest slot handed out since construction or clear(). Scans stop here.
+        ThingIdx high_water_mark() const { return high_water; }
+
+        // Changes whenever things are spawned or destroyed, change kind through set_kind(), or are
+        // attached/detached. Results derived from that structure stay valid while it is unchanged.
+        uint64_t structural_version() const { return structural_version_; }
+
+        // Changes on every call to a non-const member, so a copy taken while it is unchanged is still
+        // current. Writes through a T& kept from an earlier call are not seen.
+        uint64_t write_version() const { return write_version_; }
+
+        // The Policy::hooks object, for wiring it to the systems it feeds.
+        Hooks& hooks() { write_version_++; return hooks_; }
+        const Hooks& hooks() const { return hooks_; }
+
+        // Writes ref's .kind and bumps the structural version. Invalid refs are ignored.
+        template <typename Kind>
+        void set_kind(ThingRef ref, const Kind& kind) {
+            write_version_++;
+            static_assert(
+                requires(T& value, const Kind& new_kind) { value.kind = new_kind; },
+                "ThingPool::set_kind requires payload T to have an assignable .kind field."
+            );
+            if (!is_valid(ref)) return;
+            get_node(ref).data.kind = kind;
+            mark_changed(ref.index);
+            structural_version_++;
+        }
+
+        bool is_valid(ThingRef ref) const {
+            return ref.index > 0 &&
+                   ref.index < high_water &&
+                   nodes[ref.index].is_active &&
+                   nodes[ref.index].generation == ref.generation;
+        }
+
+        T& get(ThingRef ref) {
+            write_version_++;
+            assert(is_valid(ref) && "ThingPool::get called with invalid ThingRef.");
+            return get_node(ref).data;
+        }
+
+        const T& get(ThingRef ref) const {
+            assert(is_valid(ref) && "ThingPool::get called with invalid ThingRef.");
+            return get_node(ref).data;
+        }
+
+        PoolView<T, MAX_THINGS, Policy> view() { return PoolView<T, MAX_THINGS, Policy>(*this); }
+        PoolView<const T, MAX_THINGS, Policy> view() const { return PoolView<const T, MAX_THINGS, Policy>(*this); }
+
+        // --- Batch Lookup ---
+        // Writes one bit per ref (bit i of word i / 64) and returns the number of valid refs.
+        size_t validate_batch(std::span<const ThingRef> refs, std::span<uint64_t> valid_bits) const {
+            assert(valid_bits.size() * 64 >= refs.size() && "ThingPool::validate_batch bitmask is too small.");
+            size_t valid = 0;
+            for (size_t first = 0; first < refs.size(); first += 64) {
+                const uint64_t mask = validate_block(refs, first, std::min<size_t>(64, refs.size() - first));
+                valid_bits[first / 64] = mask;
+                valid += static_cast<size_t>(std::popcount(mask));
+            }
+            return valid;
+        }
+
+        // Writes the payload pointer for each valid ref and nullptr for stale ones.
+        size_t resolve_batch(std::span<const ThingRef> refs, std::span<T*> out) {
+            write_version_++;
+            return resolve_batch_impl(*this, refs, out);
+        }
+
+        size_t resolve_batch(std::span<const ThingRef> refs, std::span<const T*> out) const {
+            return resolve_batch_impl(*this, refs, out);
+        }
+
+        // --- Concurrent Reads ---
+        void set_epoch_domain(EpochDomain* domain) {
+            write_version_++;
+            if (domain == epoch_domain) return;
+            for (size_t bag = 0; bag < 3; ++bag) {
+                if (limbo_head[bag] != 0) release_limbo(bag);
+            }
+            epoch_domain = domain;
+        }
+
+        EpochDomain* get_epoch_domain() const { return epoch_domain; }
+
+        // Owning thread, e.g. once per tick. Makes slots retired before the grace period reusable.
+        void collect_retired() {
+            write_version_++;
+            if (epoch_domain == nullptr) return;
+            // Two steps past a retire epoch is the grace period; with no pinned readers both succeed.
+            if (epoch_domain->try_advance()) epoch_domain->try_advance();
+            const uint64_t epoch = epoch_domain->epoch();
+            for (size_t bag = 0; bag < 3; ++bag) {
+                if (limbo_head[bag] != 0 && epoch >= limbo_epoch[bag] + 2) release_limbo(bag);
+            }
+        }
+
+        // Reader threads. Returns null for invalid refs; the payload stays readable while guard is held.
+        const T* get_pinned(const EpochDomain::Guard&, ThingRef ref) const {
+            if (ref.index == 0) return nullptr;
+            const ThingIdx end = std::atomic_ref<ThingIdx>(const_cast<ThingIdx&>(high_water)).load(std::memory_order_acquire);
+            if (ref.index >= end) return nullptr;
+            Node& node = const_cast<Node&>(nodes[ref.index]);
+            if (!std::atomic_ref<bool>(node.is_active).load(std::memory_order_acquire)) return nullptr;
+            if (std::atomic_ref<Generation>(node.generation).load(std::memory_order_acquire) != ref.generation) {
+                return nullptr;
+            }
+            return &node.data;
+        }
+
+        void attach_child(ThingRef parent_ref, ThingRef child_ref) requires Policy::hierarchy {
+            write_version_++;
+            Node& parent = get_node(parent_ref);
+            Node& child = get_node(child_ref);
+            if (&parent == &nodes[0] || &child == &nodes[0]) return;
+            structural_version_++;
+            
+            if (child.parent != 0) detach(child_ref);
+            child.parent = parent_ref.index;
+
+            if (parent.first_child == 0) {
+                parent.first_child = child_ref.index;
+                child.next_sibling = child_ref.index;
+                child.prev_sibling = child_ref.index;
+            } else {
+                ThingIdx first_child = parent.first_child;
+                ThingIdx last_child = nodes[first_child].prev_sibling;
+                nodes[last_child].next_sibling = child_ref.index;
+                child.prev_sibling = last_child;
+                child.next_sibling = first_child;
+                nodes[first_child].prev_sibling = child_ref.index;
+            }
+        }
+
+        void detach(ThingRef ref) requires Policy::hierarchy {
+            write_version_++;
+            Node& node = get_node(ref);
+            if (&node == &nodes[0] || node.parent == 0) return;
+            structural_version_++;
+            Node& parent = nodes[node.parent];
+
+            if (node.next_sibling == ref.index) {
+                parent.first_child = 0;
+            } else {
+                nodes[node.prev_sibling].next_sibling = node.next_sibling;
+                nodes[node.next_sibling].prev_sibling = node.prev_sibling;
+                if (parent.first_child == ref.index) parent.first_child = node.next_sibling;
+            }
+
+            node.parent = 0;
+            node.next_sibling = 0;
+            node.prev_sibling = 0;
+        }
+
+        // --- Iteration Subsystem ---
+        template <typename U>
+        struct BasicPoolItem {
+            ThingRef ref;
+            U& data;
+        };
+
+        using PoolItem = BasicPoolItem<T>;
+        using ConstPoolItem = BasicPoolItem<const T>;
+
+        template <typename U>
+        class BasicIterator {
+            using PoolPtr = std::conditional_t<std::is_const_v<U>, const ThingPool*, ThingPool*>;
+            PoolPtr pool;
+            ThingIdx current_idx;
+            // Past the high-water mark the iterator parks on MAX_THINGS, which end() also uses.
+            void advance_to_next_active() {
+                while (current_idx < pool->high_water && !pool->nodes[current_idx].is_active) {
+                    pool->prefetch_scan(current_idx);
+                    current_idx++;
+                }
+                if (current_idx >= pool->high_water) current_idx = MAX_THINGS;
+            }
+        public:
+            BasicIterator(PoolPtr p, ThingIdx start_idx) : pool(p), current_idx(start_idx) {
+                if (current_idx < MAX_THINGS) advance_to_next_active();
+            }
+            bool operator!=(const BasicIterator& other) const { return current_idx != other.current_idx; }
+            BasicIterator& operator++() { pool->prefetch_scan(current_idx); current_idx++; advance_to_next_active(); return *this; }
+            BasicPoolItem<U> operator*() const { return { ThingRef{current_idx, pool->nodes[current_idx].generation}, pool->nodes[current_idx].data }; }
+        };
+
+        using Iterator = BasicIterator<T>;
+        using ConstIterator = BasicIterator<const T>;
+
+        Iterator begin() { write_version_++; return Iterator(this, 1); }
+        Iterator end()   { return Iterator(this, MAX_THINGS); }
+        ConstIterator begin() const { return ConstIterator(this, 1); }
+        ConstIterator end() const   { return ConstIterator(this, MAX_THINGS); }
+        ConstIterator cbegin() const { return begin(); }
+        ConstIterator cend() const   { return end(); }
+
+        // A run of up to 64 consecutive slots, starting at a multiple of 64, plus their active bits.
+        template <typename U>
+        class BasicChunk {
+            using NodePtr = std::conditional_t<std::is_const_v<U>, const Node*, Node*>;
+            NodePtr slots;
+            ThingIdx first_;
+            uint32_t count;
+            uint64_t active;
+            friend class ThingPool;
+
+            BasicChunk(NodePtr s, ThingIdx f, uint32_t c, uint64_t a) : slots(s), first_(f), count(c), active(a) {}
+        public:
+            ThingIdx first() const { return first_; }
+            size_t size() const { return count; }
+            // Bit i is set when slot first() + i is active.
+            uint64_t active_mask() const { return active; }
+            bool is_active(size_t i) const { return (active >> i) & 1; }
+            // Payload of slot first() + i, active or not. Only write slots whose bit is set.
+            U& operator[](size_t i) const { return slots[i].data; }
+            ThingRef ref(size_t i) const { return ThingRef{first_ + static_cast<ThingIdx>(i), slots[i].generation}; }
+        };
+
+        using Chunk = BasicChunk<T>;
+        using ConstChunk = BasicChunk<const T>;
+
+        template <typename Fn>
+        void for_each_chunk(Fn&& fn) {
+            write_version_++;
+            for_each_chunk_impl(*this, fn);
+        }
+
+        template <typename Fn>
+        void for_each_chunk(Fn&& fn) const {
+            for_each_chunk_impl(*this, fn);
+        }
+
+        // --- Tags (Policy::tag_bits) ---
+        // Bits outside user_tags are ignored. Invalid refs read as 0 and are not modified.
+        TagMask tags(ThingRef ref) const requires(Policy::tag_bits != 0) {
+            return is_valid(ref) ? TagMask(tag_masks[ref.index] & user_tags) : TagMask{0};
+        }
+
+        void set_tags(ThingRef ref, TagMask mask) requires(Policy::tag_bits != 0) {
+            write_version_++;
+            if (is_valid(ref)) tag_masks[ref.index] = (mask & user_tags) | tag_live;
+        }
+
+        void add_tags(ThingRef ref, TagMask mask) requires(Policy::tag_bits != 0) {
+            write_version_++;
+            if (is_valid(ref)) tag_masks[ref.index] |= mask & user_tags;
+        }
+
+        void remove_tags(ThingRef ref, TagMask mask) requires(Policy::tag_bits != 0) {
+            write_version_++;
+            if (is_valid(ref)) tag_masks[ref.index] &= ~(mask & user_tags);
+        }
+
+        // Calls fn(ref, data) for live things carrying every bit of all_of and none of none_of,
+        // in slot order. Masks are compared 8 slots at a time (AVX2) before any node is read.
+        template <typename Fn>
+        void for_tags(TagMask all_of, TagMask none_of, Fn&& fn) requires(Policy::tag_bits != 0) {
+            write_version_++;
+            for_tags_impl(*this, all_of, none_of, fn);
+        }
+
+        template <typename Fn>
+        void for_tags(TagMask all_of, TagMask none_of, Fn&& fn) const requires(Policy::tag_bits != 0) {
+            for_tags_impl(*this, all_of, none_of, fn);
+        }
+
+        // --- Change detection (Policy::change_ticks) ---
+        // Changes are stamped with the current tick. A system that runs for_changed_since(last_run)
+        // and then sets last_run = advance_tick() sees every change exactly once.
+        uint64_t change_tick() const requires Policy::change_ticks { return change_ticks.current; }
+
+        // Closes the current tick and returns it; later changes get a newer one.
+        uint64_t advance_tick() requires Policy::change_ticks { write_version_++; return change_ticks.current++; }
+
+        // Marks ref as changed in the current tick. Invalid refs are ignored.
+        void touch(ThingRef ref) requires Policy::change_ticks {
+            write_version_++;
+            if (is_valid(ref)) mark_changed(ref.index);
+        }
+
+        // get() for writing: marks ref as changed.
+        T& get_mut(ThingRef ref) requires Policy::change_ticks {
+            T& data = get(ref);
+            mark_changed(ref.index);
+            return data;
+        }
+
+        // Last tick in which ref was spawned or touched; 0 for invalid refs.
+        uint64_t changed_tick(ThingRef ref) const requires Policy::change_ticks {
+            return is_valid(ref) ? change_ticks.slots[ref.index] : 0;
+        }
+
+        // Calls fn(ref, data) for live things changed after tick, in slot order. Chunks of 64 slots
+        // with no newer change are skipped without reading their nodes.
+        template <typename Fn>
+        void for_changed_since(uint64_t tick, Fn&& fn) requires Policy::change_ticks {
+            write_version_++;
+            for_changed_since_impl(*this, tick, fn);
+        }
+
+        template <typename Fn>
+        void for_changed_since(uint64_t tick, Fn&& fn) const requires Policy::change_ticks {
+            for_changed_since_impl(*this, tick, fn);
+        }
+
+        template <typename Kind, typename Fn>
+        void for_kind(const Kind& kind, Fn&& fn) {
+            write_version_++;
+            static_assert(
+                requires(T& value, const Kind& query_kind) {
+                    { value.kind == query_kind } -> std::convertible_to<bool>;
+                },
+                "ThingPool::for_kind requires payload T to have a comparable .kind field."
+            );
+
+            for (ThingIdx idx = 1; idx < high_water; ++idx) {
+                prefetch_scan(idx);
+                Node& node = nodes[idx];
+                if (!node.is_active) continue;
+                if (!(node.data.kind == kind)) continue;
+                fn(ThingRef{idx, node.generation}, node.data);
+            }
+        }
+
+        template <typename Kind, typename Fn>
+        void for_kind(const Kind& kind, Fn&& fn) const {
+            static_assert(
+                requires(const T& value, const Kind& query_kind) {
+                    { value.kind == query_kind } -> std::convertible_to<bool>;
+                },
+                "ThingPool::for_kind requires payload T to have a comparable .kind field."
+            );
+
+            for (ThingIdx idx = 1; idx < high_water; ++idx) {
+                prefetch_scan(idx);
+                const Node& node = nodes[idx];
+                if (!node.is_active) continue;
+                if (!(node.data.kind == kind)) continue;
+                fn(ThingRef{idx, node.generation}, node.data);
+            }
+        }
+
+        // Visits slice (frame_index % slice_count) of the slot range, so every slot is visited once
+        // every slice_count frames.
+        template <typename Kind, typename Fn>
+        size_t for_kind_sliced(const Kind& kind, size_t slice_count, uint64_t frame_index, Fn&& fn) {
+            write_version_++;
+            return for_kind_sliced_impl(*this, kind, slice_count, frame_index, fn);
+        }
+
+        template <typename Kind, typename Fn>
+        size_t for_kind_sliced(const Kind& kind, size_t slice_count, uint64_t frame_index, Fn&& fn) const {
+            return for_kind_sliced_impl(*this, kind, slice_count, frame_index, fn);
+        }
+
+        // Scanning this many non-matching slots costs as much of a visit budget as one call to fn.
+        static constexpr size_t budget_scan_per_visit = 64;
+
+        // Resumes at cursor and stops after max_visits calls to fn, max_visits * budget_scan_per_visit
+        // scanned slots, or one full lap of the pool.
+        template <typename Kind, typename Fn>
+        size_t for_kind_budget(const Kind& kind, PassCursor& cursor, size_t max_visits, Fn&& fn) {
+            write_version_++;
+            return for_kind_budget_impl(*this, kind, cursor, fn, visit_budget(max_visits));
+        }
+
+        template <typename Kind, typename Fn>
+        size_t for_kind_budget(const Kind& kind, PassCursor& cursor, size_t max_visits, Fn&& fn) const {
+            return for_kind_budget_impl(*this, kind, cursor, fn, visit_budget(max_visits));
+        }
+
+        // Same, but stops once max_time has elapsed. The clock is read after each call to fn and
+        // every 64 scanned slots.
+        template <typename Kind, typename Fn>
+        size_t for_kind_budget(const Kind& kind, PassCursor& cursor, std::chrono::nanoseconds max_time, Fn&& fn) {
+            write_version_++;
+            return for_kind_budget_impl(*this, kind, cursor, fn, time_budget(max_time));
+        }
+
+        template <typename Kind, typename Fn>
+        size_t for_kind_budget(const Kind& kind, PassCursor& cursor, std::chrono::nanoseconds max_time, Fn&& fn) const {
+            return for_kind_budget_impl(*this, kind, cursor, fn, time_budget(max_time));
+        }
+
+        template <typename Pred>
+        size_t queue_destroy_if(Pred&& pred) {
+            write_version_++;
+            size_t queued = 0;
+            for (ThingIdx idx = 1; idx < high_water; ++idx) {
+                prefetch_scan(idx);
+                Node& node = nodes[idx];
+                if (!node.is_active) continue;
+
+                ThingRef ref{idx, node.generation};
+                if (!pred(ref, node.data)) continue;
+                if (destroy_later(ref)) {
+                    queued++;
+                }
+            }
+            return queued;
+        }
+
+        // Side tables passed here are appended to the snapshot after the pool, in argument order.
+        template <typename... Tables>
+        bool save_to_file(const char* filepath, const Tables&... tables) const {
+            static_assert(std::is_trivially_copyable_v<T>, "FATAL: Payload T must be trivially copyable!");
+            SaveHeader header;
+            header.first_free = first_free;
+            header.high_water = high_water;
+            // Only the used prefix of the pool is written.
+            const size_t free_bytes = Policy::intrusive_free_list ? 0 : high_water * sizeof(ThingIdx);
+            const size_t node_bytes = high_water * sizeof(Node);
+
+            const detail::SideTableHeader table_headers[sizeof...(Tables) + 1] = {tables.section_header()...};
+            const auto write = [&](const void* free_list) {
+                detail::FileSection sections[3 + 3 * sizeof...(Tables)];
+                size_t count = 0;
+                sections[count++] = {&header, sizeof(SaveHeader)};
+                sections[count++] = {free_list, free_bytes};
+                sections[count++] = {nodes, node_bytes};
+                size_t table = 0;
+                ((sections[count++] = {&table_headers[table], sizeof(detail::SideTableHeader)},
+                  sections[count++] = {tables.owners, table_headers[table].count * sizeof(ThingRef)},
+                  sections[count++] = {tables.values, table_headers[table].count * sizeof(typename Tables::value_type)},
+                  ++table), ...);
+                return detail::write_file_sections(filepath, {sections, count});
+            };
+
+            const bool has_limbo = this->has_limbo();
+
+            if constexpr (Policy::intrusive_free_list) {
+                header.flags = save_flag_intrusive;
+                // Retired and unreclaimed slots are not on the free-list, so the loader rebuilds it.
+                if (has_limbo || reclaim_head != 0) header.flags |= save_flag_rebuild;
+                return write(nullptr);
+            } else if (!has_limbo && reclaim_head == 0) {
+                return write(next_free);
+            }
+
+            // A snapshot has no readers or pending reclamation, so every reusable slot is written as
+            // free. Unreclaimed slots still hold stale links, which spawn() clears on reuse.
+            // Heap scratch sized by high_water: a MAX_THINGS array would overflow the stack of large pools.
+            const std::unique_ptr<ThingIdx[]> saved_next_free(new (std::nothrow) ThingIdx[high_water]());
+            if (!saved_next_free) return false;
+            header.first_free = 0;
+            for (ThingIdx idx = high_water - 1; idx > 0; --idx) {
+                if (nodes[idx].is_active || nodes[idx].generation >= max_generation) continue;
+                saved_next_free[idx] = header.first_free;
+                header.first_free = idx;
+            }
+            return write(saved_next_free.get());
+        }
+
+        // Side tables must be passed in the order they were saved. Nothing changes unless the pool
+        // and every table load successfully.
+        template <typename... Tables>
+        bool load_from_file(const char* filepath, Tables&... tables) {
+            write_version_++;
+            static_assert(std::is_trivially_copyable_v<T>, "FATAL: Payload T must be trivially copyable!");
+            clear_destroy_later();
+            SaveHeader header{};
+            // The header says how much of the pool follows, so it is read on its own first.
+            const detail::FileSpan header_section[] = {{&header, sizeof(SaveHeader)}};
+            if (!detail::read_file_sections(filepath, 0, header_section)) return false;
+            if (header.magic[0] != 'L' || header.magic[1] != 'O' || 
+                header.magic[2] != 'G' || header.magic[3] != 'C') return false;
+            if (header.version != SaveHeader{}.version) return false;
+            if (header.max_things != MAX_THINGS || header.node_size != sizeof(Node)) return false;
+            if (header.high_water == 0 || header.high_water > MAX_THINGS) return false;
+            if (header.first_free >= header.high_water) return false;
+            if ((header.flags & ~(save_flag_intrusive | save_flag_rebuild)) != 0) return false;
+
+            const ThingIdx loaded_high_water = header.high_water;
+            const bool file_intrusive = (header.flags & save_flag_intrusive) != 0;
+            // Staged on the heap, sized by the file: MAX_THINGS nodes would overflow the stack.
+            const std::unique_ptr<ThingIdx[]> free_scratch(new (std::nothrow) ThingIdx[loaded_high_water]());
+            const std::unique_ptr<Node[]> node_scratch(new (std::nothrow) Node[loaded_high_water]());
+            if (!free_scratch || !node_scratch) return false;
+            ThingIdx* loaded_next_free = free_scratch.get();
+            Node* loaded_nodes = node_scratch.get();
+            const size_t free_bytes = file_intrusive ? 0 : loaded_high_water * sizeof(ThingIdx);
+            const size_t node_bytes = loaded_high_water * sizeof(Node);
+            const detail::FileSpan pool_sections[] = {{loaded_next_free, free_bytes}, {loaded_nodes, node_bytes}};
+            if (!detail::read_file_sections(filepath, sizeof(SaveHeader), pool_sections)) return false;
+
+            const auto commit = [&] {
+                // Trivially copyable Nodes: copying bytes also starts their lifetime.
+                std::memcpy(static_cast<void*>(nodes), loaded_nodes, node_bytes);
+                // Older snapshots kept padding where payload_clean now lives; don't trust it.
+                // Tags are runtime state: loaded things start with none.
+                // Every loaded thing counts as changed.
+                for (ThingIdx idx = 0; idx < loaded_high_water; ++idx) {
+                    nodes[idx].payload_clean = false;
+                    set_slot_tags(idx, nodes[idx].is_active ? tag_live : 0);
+                    mark_changed(idx);
+                }
+                constructed = std::max(constructed, loaded_high_water);
+                high_water = loaded_high_water;
+                structural_version_++;
+                first_free = header.first_free;
+                clear_limbo();
+                clear_reclaim();
+                // Snapshots from a pool with the other free-list layout keep their slots but not their order.
+                if ((header.flags & save_flag_rebuild) != 0 || file_intrusive != Policy::intrusive_free_list) {
+                    rebuild_free_list();
+                    return true;
+                }
+                if constexpr (!Policy::intrusive_free_list) {
+                    std::copy_n(loaded_next_free, loaded_high_water, next_free);
+                }
+                index_free_list();
+                recount_stats();
+                return true;
+            };
+            if (!load_tables(filepath, sizeof(SaveHeader) + free_bytes + node_bytes, commit, tables...)) return false;
+            notify_reset();
+            return true;
+        }
+
+        // --- Replication ---
+        static constexpr size_t max_delta_size() {
+            constexpr size_t record_size = 2 * detail::max_varint_size +
+                                           detail::max_xor_runs_size(sizeof(ThingIdx) * 4) +
+                                           detail::max_xor_runs_size(sizeof(T));
+            return 2 + (MAX_THINGS - 1) * record_size + 1;
+        }
+
+        size_t encode_delta(ReplicationBaseline<T, MAX_THINGS>& baseline, std::span<uint8_t> out) const {
+            return encode_delta_impl(baseline, out, nullptr);
+        }
+
+        size_t encode_delta(ReplicationBaseline<T, MAX_THINGS>& baseline, std::span<uint8_t> out,
+                            const SlotBitmap<MAX_THINGS>& relevant) const {
+            return encode_delta_impl(baseline, out, &relevant);
+        }
+
+        bool apply_delta(std::span<const uint8_t> delta) {
+            write_version_++;
+            static_assert(std::is_trivially_copyable_v<T>, "FATAL: Payload T must be trivially copyable!");
+            if (!decode_delta(delta, false)) return false;
+            decode_delta(delta, true);
+            rebuild_free_list();
+            structural_version_++;
+            notify_reset();
+            return true;
+        }
+    };
+
+    // Non-owning handle to a ThingPool, cheap to copy and pass to systems.
+    // PoolView<const T, ...> only exposes reads, so any number of threads may share one while
+    // the pool is not being mutated.
+    export template <typename T, size_t MAX_THINGS, typename Policy>
+    class PoolView {
+        using Pool = std::conditional_t<std::is_const_v<T>,
+                                        const ThingPool<std::remove_const_t<T>, MAX_THINGS, Policy>,
+                                        ThingPool<T, MAX_THINGS, Policy>>;
+        Pool* pool_;
+
+    public:
+        PoolView(Pool& pool) : pool_(&pool) {}
+
+        template <typename U>
+            requires(std::is_const_v<T> && std::is_same_v<U, std::remove_const_t<T>>)
+        PoolView(PoolView<U, MAX_THINGS, Policy> other) : pool_(&other.pool()) {}
+
+        Pool& pool() const { return *pool_; }
+
+        bool is_valid(ThingRef ref) const { return pool_->is_valid(ref); }
+        T& get(ThingRef ref) const { return pool_->get(ref); }
+        PoolStats stats() const { return pool_->stats(); }
+        uint64_t structural_version() const { return pool_->structural_version(); }
+
+        auto begin() const { return pool_->begin(); }
+        auto end() const { return pool_->end(); }
+
+        template <typename Kind, typename Fn>
+        void for_kind(const Kind& kind, Fn&& fn) const { pool_->for_kind(kind, std::forward<Fn>(fn)); }
+
+        template <typename Fn>
+        void for_each_chunk(Fn&& fn) const { pool_->for_each_chunk(std::forward<Fn>(fn)); }
+
+        using TagMask = typename Pool::TagMask;
+        TagMask tags(ThingRef ref) const { return pool_->tags(ref); }
+
+        template <typename Fn>
+        void for_tags(TagMask all_of, TagMask none_of, Fn&& fn) const {
+            pool_->for_tags(all_of, none_of, std::forward<Fn>(fn));
+        }
+
+        uint64_t changed_tick(ThingRef ref) const { return pool_->changed_tick(ref); }
+
+        template <typename Fn>
+        void for_changed_since(uint64_t tick, Fn&& fn) const {
+            pool_->for_changed_since(tick, std::forward<Fn>(fn));
+        }
+    };
+
+    // Sparse per-thing storage for rare, large components, keyed by ThingIdx and checked against the
+    // owner's generation. Entries of destroyed owners are invisible at once and reclaimed by purge(),
+    // or by emplace() when the table is full. Pass tables to save_to_file()/load_from_file() to
+    // include them in snapshots, and call remap() after ThingPool::reorder().
+    export template <typename U, typename Pool, size_t CAPACITY = 1024>
+    class SideTable {
+        static_assert(CAPACITY >= 1, "SideTable requires CAPACITY >= 1.");
+        static_assert(std::is_trivially_copyable_v<U>, "FATAL: SideTable values must be trivially copyable!");
+
+        static constexpr size_t max_things = Pool::max_things;
+        static constexpr size_t capacity = std::min(CAPACITY, max_things - 1);
+
+        template <typename, size_t, typename> friend class ThingPool;
+
+        const Pool* pool_;
+        // Dense position of each slot's entry; only meaningful when owners[] at that position agrees.
+        ThingIdx sparse[max_things] = {};
+        ThingRef owners[capacity] = {};
+        U values[capacity] = {};
+        ThingIdx count_ = 0;
+
+        ThingIdx position(ThingIdx idx) const {
+            const ThingIdx pos = sparse[idx];
+            return pos < count_ && owners[pos].index == idx ? pos : ThingIdx(capacity);
+        }
+
+        void remove_at(ThingIdx pos) {
+            const ThingIdx last = --count_;
+            if (pos != last) {
+                owners[pos] = owners[last];
+                values[pos] = values[last];
+                sparse[owners[pos].index] = pos;
+            }
+        }
+
+        detail::SideTableHeader section_header() const {
+            detail::SideTableHeader header;
+            header.value_size = sizeof(U);
+            header.count = count_;
+            return header;
+        }
+
+        // Reads this table's section at offset and validates it, then lets next() load whatever
+        // follows. The table only changes if next() succeeds.
+        template <typename Next>
+        bool load_section(const char* filepath, size_t offset, Next&& next) {
+            detail::SideTableHeader header{};
+            const detail::FileSpan header_section[] = {{&header, sizeof(header)}};
+            if (!detail::read_file_sections(filepath, offset, header_section)) return false;
+            if (header.magic[0] != 'L' || header.magic[1] != 'O' ||
+                header.magic[2] != 'S' || header.magic[3] != 'T') return false;
+            if (header.value_size != sizeof(U) || header.count > capacity) return false;
+
+            // Staged on the heap: a table's worth of values would overflow the stack, all the more so
+            // inside load_from_file().
+            const std::unique_ptr<ThingRef[]> loaded_owners(new (std::nothrow) ThingRef[header.count]);
+            const std::unique_ptr<U[]> loaded_values(new (std::nothrow) U[header.count]());
+            const std::unique_ptr<SlotBitmap<max_things>> seen(new (std::nothrow) SlotBitmap<max_things>());
+            if (!loaded_owners || !loaded_values || !seen) return false;
+            const size_t owner_bytes = header.count * sizeof(ThingRef);
+            const size_t value_bytes = header.count * sizeof(U);
+            const detail::FileSpan sections[] = {{loaded_owners.get(), owner_bytes}, {loaded_values.get(), value_bytes}};
+            if (!detail::read_file_sections(filepath, offset + sizeof(header), sections)) return false;
+
+            for (ThingIdx i = 0; i < header.count; ++i) {
+                const ThingIdx idx = loaded_owners[i].index;
+                if (idx == 0 || idx >= max_things || seen->test(idx)) return false;
+                seen->set(idx);
+            }
+            if (!next(offset + sizeof(header) + owner_bytes + value_bytes)) return false;
+
+            count_ = static_cast<ThingIdx>(header.count);
+            std::copy_n(loaded_owners.get(), count_, owners);
+            std::copy_n(loaded_values.get(), count_, values);
+            for (ThingIdx pos = 0; pos < count_; ++pos) sparse[owners[pos].index] = pos;
+            return true;
+        }
+
+    public:
+        using value_type = U;
+
+        explicit SideTable(const Pool& pool) : pool_(&pool) {}
+
+        // nullptr unless ref is alive and has an entry.
+        U* find(ThingRef ref) {
+            return const_cast<U*>(std::as_const(*this).find(ref));
+        }
+
+        const U* find(ThingRef ref) const {
+            if (ref.index == 0 || ref.index >= max_things) return nullptr;
+            const ThingIdx pos = position(ref.index);
+            if (pos == capacity || owners[pos].generation != ref.generation) return nullptr;
+            return pool_->is_valid(ref) ? &values[pos] : nullptr;
+        }
+
+        bool contains(ThingRef ref) const { return find(ref) != nullptr; }
+
+        // Adds value for ref, or returns ref's existing value unchanged. nullptr if ref is not alive
+        // or the table is still full after dropping dead owners.
+        U* emplace(ThingRef ref, const U& value = U{}) {
+            if (!pool_->is_valid(ref)) return nullptr;
+            ThingIdx pos = position(ref.index);
+            if (pos != capacity) {
+                // A stale entry left by the slot's previous owner is taken over.
+                if (owners[pos].generation != ref.generation) {
+                    owners[pos] = ref;
+                    values[pos] = value;
+                }
+                return &values[pos];
+            }
+            if (count_ == capacity && purge() == 0) return nullptr;
+            pos = count_++;
+            owners[pos] = ref;
+            values[pos] = value;
+            sparse[ref.index] = pos;
+            return &values[pos];
+        }
+
+        bool erase(ThingRef ref) {
+            if (ref.index == 0 || ref.index >= max_things) return false;
+            const ThingIdx pos = position(ref.index);
+            if (pos == capacity || owners[pos].generation != ref.generation) return false;
+            remove_at(pos);
+            return true;
+        }
+
+        // Drops entries whose owner has been destroyed; returns how many were dropped.
+        size_t purge() {
+            size_t dropped = 0;
+            for (ThingIdx pos = 0; pos < count_;) {
+                if (pool_->is_valid(owners[pos])) {
+                    ++pos;
+                } else {
+                    remove_at(pos);
+                    ++dropped;
+                }
+            }
+            return dropped;
+        }
+
+        // Moves entries to their owners' new slots after ThingPool::reorder(). Entries of stale owners
+        // are dropped.
+        void remap(std::span<const RefRemap> table) {
+            for (ThingIdx pos = 0; pos < count_;) {
+                const ThingRef moved = remap_ref(table, owners[pos]);
+                if (moved == NilRef) {
+                    remove_at(pos);
+                    continue;
+                }
+                owners[pos] = moved;
+                ++pos;
+            }
+            for (ThingIdx pos = 0; pos < count_; ++pos) sparse[owners[pos].index] = pos;
+        }
+
+        // Counts entries of dead owners until they are purged.
+        size_t size() const { return count_; }
+        static constexpr size_t max_size() { return capacity; }
+        void clear() { count_ = 0; }
+
+        // Calls fn(ThingRef, U&) for every entry with a live owner, in dense order.
+        template <typename Fn>
+        void for_each(Fn&& fn) {
+            for (ThingIdx pos = 0; pos < count_; ++pos) {
+                if (pool_->is_valid(owners[pos])) fn(owners[pos], values[pos]);
+            }
+        }
+    };
+
+    // The refs of every live thing matching a predicate, recomputed only when the pool's
+    // structural_version() moved. The predicate must only depend on structure (kind, parent,
+    // existence); call invalidate() after changing anything else it reads.
+    export template <typename Pool, typename Pred>
+    class CachedQuery {
+        static constexpr size_t capacity = std::remove_const_t<Pool>::max_things - 1;
+
+        Pool* pool_;
+        Pred pred;
+        uint64_t version = 0;
+        bool fresh = false;
+        ThingIdx count_ = 0;
+        ThingRef matches[capacity];
+
+        void refresh() {
+            if (fresh && version == pool_->structural_version()) return;
+            count_ = 0;
+            for (auto item : *pool_) {
+                if (pred(std::as_const(item.data))) matches[count_++] = item.ref;
+            }
+            version = pool_->structural_version();
+            fresh = true;
+        }
+
+    public:
+        CachedQuery(Pool& pool, Pred pred) : pool_(&pool), pred(std::move(pred)) {}
+
+        // Matching refs in slot order, recomputed first if the pool's structure changed.
+        std::span<const ThingRef> refs() {
+            refresh();
+            return {matches, count_};
+        }
+
+        // Calls fn(ref, data) for every match. fn must not change the pool's structure.
+        template <typename Fn>
+        void for_each(Fn&& fn) {
+            refresh();
+            for (ThingIdx i = 0; i < count_; ++i) fn(matches[i], pool_->get(matches[i]));
+        }
+
+        size_t size() {
+            refresh();
+            return count_;
+        }
+
+        // True when the next call will rescan the pool.
+        bool stale() const { return !fresh || version != pool_->structural_version(); }
+        void invalidate() { fresh = false; }
+    };
+
+    // Hierarchical timing wheel that queues things for destroy_later() once their time is up.
+    // Four levels of 64 buckets cover delays up to 64^4 - 1 ticks; each advance() only touches the
+    // timers that expire or move down a level. Timers hold refs, so things destroyed early (and
+    // slots reused since) are skipped.
+    export template <typename Pool, size_t CAPACITY = 1024>
+    class ExpiryWheel {
+        static_assert(CAPACITY >= 1 && CAPACITY < ThingIdx(~ThingIdx{0}), "ExpiryWheel requires 1 <= CAPACITY < 2^32 - 1.");
+
+        static constexpr unsigned level_bits = 6;
+        static constexpr unsigned level_count = 4;
+        static constexpr uint64_t bucket_mask = (uint64_t{1} << level_bits) - 1;
+
+        struct Timer {
+            ThingRef ref = NilRef;
+            uint64_t deadline = 0;
+            ThingIdx next = 0;
+        };
+
+        Pool* pool_;
+        uint64_t now_ = 0;
+        ThingIdx scheduled_ = 0;
+        ThingIdx first_free = 0;
+        ThingIdx high_water = 1;
+        // Singly linked timer lists per bucket; index 0 is nil, as in ThingPool.
+        ThingIdx buckets[level_count][bucket_mask + 1] = {};
+        Timer timers[CAPACITY + 1];
+
+        void insert(ThingIdx timer) {
+            const uint64_t deadline = timers[timer].deadline;
+            const uint64_t delay = deadline - now_;
+            unsigned level = 0;
+            while (level + 1 < level_count && delay >> (level_bits * (level + 1)) != 0) ++level;
+            ThingIdx& head = buckets[level][(deadline >> (level_bits * level)) & bucket_mask];
+            timers[timer].next = head;
+            head = timer;
+        }
+
+        void release(ThingIdx timer) {
+            timers[timer].next = first_free;
+            first_free = timer;
+            scheduled_--;
+        }
+
+        // One tick: cascade higher levels whose bucket comes due, then expire level 0.
+        size_t step() {
+            ++now_;
+            for (unsigned level = 1; level < level_count; ++level) {
+                if ((now_ & ((uint64_t{1} << (level_bits * level)) - 1)) != 0) break;
+                ThingIdx& head = buckets[level][(now_ >> (level_bits * level)) & bucket_mask];
+                ThingIdx timer = head;
+                head = 0;
+                while (timer != 0) {
+                    const ThingIdx next = timers[timer].next;
+                    insert(timer);
+                    timer = next;
+                }
+            }
+
+            size_t queued = 0;
+            ThingIdx& head = buckets[0][now_ & bucket_mask];
+            ThingIdx timer = head;
+            head = 0;
+            while (timer != 0) {
+                const ThingIdx next = timers[timer].next;
+                const ThingRef ref = timers[timer].ref;
+                if (!pool_->is_valid(ref)) {
+                    release(timer);
+                } else if (pool_->destroy_later(ref)) {
+                    queued++;
+                    release(timer);
+                } else {
+                    // The destroy queue is full; try again next tick.
+                    timers[timer].deadline = now_ + 1;
+                    insert(timer);
+                }
+                timer = next;
+            }
+            return queued;
+        }
+
+    public:
+        static constexpr uint64_t max_delay = (uint64_t{1} << (level_bits * level_count)) - 1;
+
+        explicit ExpiryWheel(Pool& pool) : pool_(&pool) {}
+
+        // Queues ref for destroy_later() on the ticks-th advance from now (at least the next one).
+        // Returns false for invalid refs, delays above max_delay, or when CAPACITY timers are pending.
+        bool schedule_destroy(ThingRef ref, uint64_t ticks) {
+            if (!pool_->is_valid(ref) || ticks > max_delay) return false;
+            ThingIdx timer = first_free;
+            if (timer != 0) {
+                first_free = timers[timer].next;
+            } else if (high_water <= CAPACITY) {
+                timer = high_water++;
+            } else {
+                return false;
+            }
+            timers[timer].ref = ref;
+            timers[timer].deadline = now_ + std::max<uint64_t>(ticks, 1);
+            insert(timer);
+            scheduled_++;
+            return true;
+        }
+
+        // Moves time forward and hands every expired, still valid ref to destroy_later(). Returns the
+        // number queued; flush_destroy_later() destroys them.
+        size_t advance(uint64_t ticks = 1) {
+            size_t queued = 0;
+            for (uint64_t i = 0; i < ticks; ++i) queued += step();
+            return queued;
+        }
+
+        // Points timers at their things' new slots after ThingPool::reorder(). Timers of stale refs
+        // are kept and skipped on expiry.
+        void remap(std::span<const RefRemap> table) {
+            for (ThingIdx timer = 1; timer < high_water; ++timer) timers[timer].ref = remap_ref(table, timers[timer].ref);
+        }
+
+        uint64_t now() const { return now_; }
+        // Pending timers, including ones whose thing was destroyed early.
+        size_t size() const { return scheduled_; }
+
+        void clear() {
+            for (auto& level : buckets) std::fill(std::begin(level), std::end(level), ThingIdx{0});
+            first_free = 0;
+            high_water = 1;
+            scheduled_ = 0;
+        }
+    };
+
+    // --- Deferred Structural Commands ---
+    // Per-thread recording of spawn/destroy/attach_child/detach for later playback on the owning
+    // thread. Commands are applied in (sort_key, record order) order, so the result does not depend
+    // on how work was split across buffers as long as each key is recorded by a single buffer.
+    export template <typename T, size_t MAX_COMMANDS = 1024>
+    class CommandBuffer {
+        static_assert(MAX_COMMANDS >= 1, "CommandBuffer requires MAX_COMMANDS >= 1.");
+
+        enum class Op : uint8_t { spawn, destroy, attach_child, detach };
+
+        struct Command {
+            uint64_t sort_key = 0;
+            uint32_t sequence = 0;
+            Op op = Op::spawn;
+            ThingRef a;
+            ThingRef b;
+        };
+
+        Command commands[MAX_COMMANDS] = {};
+        T spawn_data[MAX_COMMANDS] = {};
+        ThingRef spawned[MAX_COMMANDS] = {};
+        size_t command_count_ = 0;
+        size_t spawn_count_ = 0;
+        size_t cursor = 0;
+
+        bool record(uint64_t sort_key, Op op, ThingRef a, ThingRef b) {
+            if (command_count_ >= MAX_COMMANDS) return false;
+            commands[command_count_] = {sort_key, static_cast<uint32_t>(command_count_), op, a, b};
+            command_count_++;
+            return true;
+        }
+
+        static bool is_placeholder(ThingRef ref) { return ref.index != 0 && ref.generation == 0; }
+
+        template <size_t MAX_THINGS, typename Policy>
+        size_t apply(ThingPool<T, MAX_THINGS, Policy>& pool, const Command& command) {
+            const ThingRef a = resolve(command.a);
+            const ThingRef b = resolve(command.b);
+            switch (command.op) {
+                case Op::spawn: {
+                    const ThingRef ref = pool.spawn_with(spawn_data[command.a.index - 1]);
+                    spawned[command.a.index - 1] = ref;
+                    if (!ref) return 0;
+                    return 1;
+                }
+                case Op::destroy:
+                    if (!pool.is_valid(a)) return 0;
+                    pool.destroy(a);
+                    return 1;
+                case Op::attach_child:
+                    if constexpr (Policy::hierarchy) {
+                        if (!pool.is_valid(a) || !pool.is_valid(b)) return 0;
+                        pool.attach_child(a, b);
+                        return 1;
+                    }
+                    return 0;
+                case Op::detach:
+                    if constexpr (Policy::hierarchy) {
+                        if (!pool.is_valid(a)) return 0;
+                        pool.detach(a);
+                        return 1;
+                    }
+                    return 0;
+            }
+            return 0;
+        }
+
+        void sort_commands() {
+            std::sort(commands, commands + command_count_, [](const Command& lhs, const Command& rhs) {
+                if (lhs.sort_key != rhs.sort_key) return lhs.sort_key < rhs.sort_key;
+                return lhs.sequence < rhs.sequence;
+            });
+        }
+
+    public:
+        // Returns a placeholder ref ({local id + 1, generation 0}) usable in later commands of this
+        // buffer, or NilRef when the buffer is full.
+        ThingRef spawn(uint64_t sort_key, const T& init = T{}) {
+            if (command_count_ >= MAX_COMMANDS || spawn_count_ >= MAX_COMMANDS) return NilRef;
+            const ThingRef placeholder{static_cast<ThingIdx>(spawn_count_ + 1), 0};
+            spawn_data[spawn_count_] = init;
+            spawned[spawn_count_] = NilRef;
+            spawn_count_++;
+            record(sort_key, Op::spawn, placeholder, NilRef);
+            return placeholder;
+        }
+
+        bool destroy(uint64_t sort_key, ThingRef ref) { return record(sort_key, Op::destroy, ref, NilRef); }
+        bool attach_child(uint64_t sort_key, ThingRef parent, ThingRef child) {
+            return record(sort_key, Op::attach_child, parent, child);
+        }
+        bool detach(uint64_t sort_key, ThingRef ref) { return record(sort_key, Op::detach, ref, NilRef); }
+
+        // Real ref for a placeholder from this buffer once played back (NilRef before, or if the
+        // pool was full). Other refs are returned unchanged.
+        ThingRef resolve(ThingRef ref) const {
+            if (!is_placeholder(ref)) return ref;
+            if (ref.index > spawn_count_) return NilRef;
+            return spawned[ref.index - 1];
+        }
+
+        size_t size() const { return command_count_; }
+        bool empty() const { return command_count_ == 0; }
+
+        // Drops recorded commands and forgets placeholder resolutions.
+        void clear() {
+            command_count_ = 0;
+            spawn_count_ = 0;
+        }
+
+        template <size_t MAX_THINGS, typename Policy>
+        size_t playback(ThingPool<T, MAX_THINGS, Policy>& pool) {
+            CommandBuffer* self = this;
+            return playback(pool, std::span<CommandBuffer* const>(&self, 1));
+        }
+
+        // Owning thread, after all recording threads are done. Merges the buffers by sort key and
+        // applies every command. Played commands are consumed; placeholders stay resolvable until
+        // clear(). Returns the number of commands that took effect (stale refs are skipped).
+        template <size_t MAX_THINGS, typename Policy>
+        static size_t playback(ThingPool<T, MAX_THINGS, Policy>& pool, std::span<CommandBuffer* const> buffers) {
+            for (CommandBuffer* buffer : buffers) buffer->sort_commands();
+
+            size_t applied = 0;
+            while (true) {
+                CommandBuffer* next = nullptr;
+                for (CommandBuffer* buffer : buffers) {
+                    if (buffer->cursor == buffer->command_count_) continue;
+                    if (next != nullptr) {
+                        // The winner would follow the buffers' order, which changes with the thread split.
+                        assert(buffer->commands[buffer->cursor].sort_key != next->commands[next->cursor].sort_key &&
+                               "CommandBuffer::playback: a sort_key was recorded by more than one buffer.");
+                    }
+                    if (next == nullptr ||
+                        buffer->commands[buffer->cursor].sort_key < next->commands[next->cursor].sort_key) {
+                        next = buffer;
+                    }
+                }
+                if (next == nullptr) break;
+                applied += next->apply(pool, next->commands[next->cursor]);
+                next->cursor++;
+            }
+
+            for (CommandBuffer* buffer : buffers) {
+                buffer->command_count_ = 0;
+                buffer->cursor = 0;
+            }
+            return applied;
+        }
+    };
+
+    // --- Copy-On-Write Forking ---
+    // A private copy-on-write mapping of a ForkablePool. Pages are shared with the parent until written.
+    export template <typename T, size_t MAX_THINGS, typename Policy = DefaultPoolPolicy>
+    class PoolFork {
+        template <typename, size_t, typename> friend class ForkablePool;
+        using Pool = ThingPool<T, MAX_THINGS, Policy>;
+
+        Pool* pool_ = nullptr;
+        size_t size = 0;
+
+        PoolFork(void* address, size_t mapped_size)
+            : pool_(address ? std::launder(static_cast<Pool*>(address)) : nullptr), size(mapped_size) {}
+
+    public:
+        PoolFork(PoolFork&& other) noexcept
+            : pool_(std::exchange(other.pool_, nullptr)), size(other.size) {}
+
+        PoolFork& operator=(PoolFork&& other) noexcept {
+            if (this != &other) {
+                discard();
+                pool_ = std::exchange(other.pool_, nullptr);
+                size = other.size;
+            }
+            return *this;
+        }
+
+        PoolFork(const PoolFork&) = delete;
+        PoolFork& operator=(const PoolFork&) = delete;
+
+        ~PoolFork() { discard(); }
+
+        void discard() {
+            if (pool_ == nullptr) return;
+            detail::unmap_private_copy(pool_, size);
+            pool_ = nullptr;
+        }
+
+        explicit operator bool() const { return pool_ != nullptr; }
+        Pool& pool() { return *pool_; }
+        const Pool& pool() const { return *pool_; }
+        Pool* operator->() { return pool_; }
+        const Pool* operator->() const { return pool_; }
+        Pool& operator*() { return *pool_; }
+        const Pool& operator*() const { return *pool_; }
+    };
+
+    // A ThingPool placed in shareable memory so fork() is a single mapping call while the parent is
+    // unchanged. The first fork freezes the backing file as a snapshot and moves the parent onto
+    // private copy-on-write pages, so later parent writes never reach existing forks; the first
+    // fork after a write copies the parent's used slots into a new file.
+    export template <typename T, size_t MAX_THINGS, typename Policy = DefaultPoolPolicy>
+    class ForkablePool {
+        static_assert(std::is_trivially_copyable_v<T>, "FATAL: Payload T must be trivially copyable!");
+        using Pool = ThingPool<T, MAX_THINGS, Policy>;
+
+        // The parent's view of region is remapped in place, so root never moves.
+        mutable detail::SharedRegion region;
+        Pool* root = nullptr;
+        // region's file is a frozen snapshot and the parent lives on private pages.
+        mutable bool parent_private = false;
+        // root->write_version() when region's file was frozen.
+        mutable uint64_t frozen_version = 0;
+
+        // Makes region's file match the parent and freezes it. Free while the parent's
+        // write_version() is unchanged since the last fork; otherwise the used part of the parent
+        // is copied into a new file once.
+        bool freeze() const {
+            if (parent_private && root->write_version() == frozen_version) return true;
+            if (!parent_private) {
+                if (!detail::remap_private(region)) return false;
+            } else {
+                detail::SharedRegion fresh;
+                if (!detail::create_shared_region(region.size, fresh)) return false;
+                root->copy_used_to(fresh.address);
+                detail::unmap_private_copy(fresh.address, fresh.size);
+                fresh.address = region.address;
+                if (!detail::remap_private(fresh)) {
+                    detail::close_region_handle(fresh);
+                    return false;
+                }
+                // Existing forks keep the old file alive through their own mappings.
+                detail::close_region_handle(region);
+                region = fresh;
+            }
+            parent_private = true;
+            frozen_version = root->write_version();
+            return true;
+        }
+
+    public:
+        ForkablePool() {
+            if (detail::create_shared_region(sizeof(Pool), region)) {
+                root = ::new (region.address) Pool();
+            }
+        }
+
+        ~ForkablePool() {
+            if (root == nullptr) return;
+            root->~Pool();
+            detail::destroy_shared_region(region);
+        }
+
+        ForkablePool(const ForkablePool&) = delete;
+        ForkablePool& operator=(const ForkablePool&) = delete;
+
+        explicit operator bool() const { return root != nullptr; }
+        Pool& pool() { return *root; }
+        const Pool& pool() const { return *root; }
+        Pool* operator->() { return root; }
+        const Pool* operator->() const { return root; }
+        Pool& operator*() { return *root; }
+        const Pool& operator*() const { return *root; }
+
+        PoolFork<T, MAX_THINGS, Policy> fork() const {
+            if (root == nullptr || !freeze()) return PoolFork<T, MAX_THINGS, Policy>(nullptr, 0);
+            return PoolFork<T, MAX_THINGS, Policy>(detail::map_private_copy(region), region.size);
+        }
+    };
+
+    // --- Published Read Views ---
+    // How ViewPublisher::publish() finds the chunks to rewrite.
+    export enum class PublishMode : uint8_t {
+        // Compares every used chunk with the target buffer. Sees every write.
+        compare_bytes,
+        // Policy::change_ticks only: copies chunks with a change stamped since the target buffer's last
+        // copy and skips the rest unread. Payload writes not stamped by get_mut, touch or set_kind may
+        // never reach the views.
+        stamped_only,
+    };
+
+    // Lock-free hand-off of consistent pool copies from the simulation thread to reader threads.
+    // Holds MAX_READERS + 2 buffers: one being written, the latest published one, and one per reader.
+    export template <typename T, size_t MAX_THINGS, size_t MAX_READERS = 1, typename Policy = DefaultPoolPolicy>
+    class ViewPublisher {
+        static_assert(MAX_READERS >= 1, "ViewPublisher requires MAX_READERS >= 1.");
+
+        using Node = typename ThingPool<T, MAX_THINGS, Policy>::Node;
+
+        static constexpr uint32_t buffer_count = static_cast<uint32_t>(MAX_READERS + 2);
+        static constexpr size_t chunk_size = 64;
+
+        struct Buffer {
+            Node nodes[MAX_THINGS] = {};
+            ThingIdx high_water = 1;
+            uint64_t sequence = 0;
+            // PublishMode::stamped_only: what this buffer was last copied from, so later publishes
+            // can copy only chunks changed since then.
+            const void* source = nullptr;
+            uint64_t version = 0;
+            uint64_t tick = 0;
+        };
+
+        Buffer buffers[buffer_count] = {};
+        std::atomic<uint32_t> readers[buffer_count] = {};
+        std::atomic<uint32_t> latest{0};
+        uint64_t published = 0;
+        PublishMode mode = PublishMode::compare_bytes;
+
+    public:
+        ViewPublisher() = default;
+        explicit ViewPublisher(PublishMode publish_mode) requires Policy::change_ticks : mode(publish_mode) {}
+
+        class ReadView {
+            friend class ViewPublisher;
+
+            ViewPublisher* publisher = nullptr;
+            uint32_t buffer = 0;
+
+            ReadView(ViewPublisher* p, uint32_t b) : publisher(p), buffer(b) {}
+            const Node* nodes() const { return publisher->buffers[buffer].nodes; }
+            ThingIdx high_water() const { return publisher->buffers[buffer].high_water; }
+
+        public:
+            struct Item {
+                ThingRef ref;
+                const T& data;
+            };
+
+            class Iterator {
+                const Node* nodes;
+                ThingIdx end;
+                ThingIdx current_idx;
+                void advance_to_next_active() {
+                    while (current_idx < end && !nodes[current_idx].is_active) current_idx++;
+                }
+            public:
+                Iterator(const Node* n, ThingIdx e, ThingIdx start_idx) : nodes(n), end(e), current_idx(start_idx) {
+                    advance_to_next_active();
+                }
+                bool operator!=(const Iterator& other) const { return current_idx != other.current_idx; }
+                Iterator& operator++() { current_idx++; advance_to_next_active(); return *this; }
+                Item operator*() const { return { ThingRef{current_idx, nodes[current_idx].generation}, nodes[current_idx].data }; }
+            };
+
+            ReadView(ReadView&& other) noexcept
+                : publisher(std::exchange(other.publisher, nullptr)), buffer(other.buffer) {}
+
+            ReadView& operator=(ReadView&& other) noexcept {
+                if (this != &other) {
+                    release();
+                    publisher = std::exchange(other.publisher, nullptr);
+                    buffer = other.buffer;
+                }
+                return *this;
+            }
+
+            ReadView(const ReadView&) = delete;
+            ReadView& operator=(const ReadView&) = delete;
+
+            ~ReadView() { release(); }
+
+            void release() {
+                if (publisher == nullptr) return;
+                publisher->readers[buffer].fetch_sub(1);
+                publisher = nullptr;
+            }
+
+            uint64_t sequence() const { return publisher->buffers[buffer].sequence; }
+
+            bool is_valid(ThingRef ref) const {
+                return ref.index > 0 &&
+                       ref.index < high_water() &&
+                       nodes()[ref.index].is_active &&
+                       nodes()[ref.index].generation == ref.generation;
+            }
+
+            const T& get(ThingRef ref) const {
+                assert(is_valid(ref) && "ReadView::get called with invalid ThingRef.");
+                return is_valid(ref) ? nodes()[ref.index].data : nodes()[0].data;
+            }
+
+            Iterator begin() const { return Iterator(nodes(), high_water(), 1); }
+            Iterator end() const   { return Iterator(nodes(), high_water(), high_water()); }
+
+            template <typename Kind, typename Fn>
+            void for_kind(const Kind& kind, Fn&& fn) const {
+                static_assert(
+                    requires(const T& value, const Kind& query_kind) {
+                        { value.kind == query_kind } -> std::convertible_to<bool>;
+                    },
+                    "ReadView::for_kind requires payload T to have a comparable .kind field."
+                );
+
+                const Node* view_nodes = nodes();
+                const ThingIdx end = high_water();
+                for (ThingIdx idx = 1; idx < end; ++idx) {
+                    const Node& node = view_nodes[idx];
+                    if (!node.is_active) continue;
+                    if (!(node.data.kind == kind)) continue;
+                    fn(ThingRef{idx, node.generation}, node.data);
+                }
+            }
+        };
+
+        // Simulation thread only. Never waits for readers.
+        void publish(const ThingPool<T, MAX_THINGS, Policy>& pool) {
             static_assert(std::is_trivially_copyable_v<T>, "FATAL: Payload T must be trivially copyable!");
-            clear_destroy_later();
-            SaveHeader header{};
-            ThingIdx loaded_next_free[MAX_THINGS] = {};
-            Node loaded_nodes[MAX_THINGS] = {};
-            
-            bool success = detail::read_pool_from_disk(filepath, &header, sizeof(SaveHeader), 
-                                                       loaded_next_free, sizeof(loaded_next_free), 
-                                                       loaded_nodes, sizeof(loaded_nodes));
-            if (success) {
-                if (header.magic[0] != 'L' || header.magic[1] != 'O' || 
-                    header.magic[2] != 'G' || header.magic[3] != 'C') return false;
-                if (header.max_things != MAX_THINGS || header.node_size != sizeof(Node)) return false;
-                if (header.first_free >= MAX_THINGS) return false;
-
-                std::copy_n(loaded_next_free, MAX_THINGS, next_free);
-                std::copy_n(loaded_nodes, MAX_THINGS, nodes);
-                first_free = header.first_free;
-                return true;
+            const uint32_t current = latest.load(std::memory_order_relaxed);
+            uint32_t target = buffer_count;
+            for (uint32_t b = 0; b < buffer_count; ++b) {
+                if (b != current && readers[b].load() == 0) {
+                    target = b;
+                    break;
+                }
+            }
+            assert(target != buffer_count && "ViewPublisher: more concurrent ReadViews than MAX_READERS.");
+
+            // Only chunks that differ from what the target buffer already holds are rewritten.
+            Buffer& buffer = buffers[target];
+            Node* dst = buffer.nodes;
+            const size_t used = pool.high_water;
+            bool compare = true;
+            if constexpr (Policy::change_ticks) {
+                static_assert(chunk_size == 64, "ViewPublisher chunks must match the pool's change-tick chunks.");
+                // Same pool and no structural change since this buffer's last copy: payload changes
+                // are taken to be stamped in the chunk ticks, so clean chunks are skipped unread.
+                if (mode == PublishMode::stamped_only && buffer.source == &pool &&
+                    buffer.version == pool.structural_version_) {
+                    compare = false;
+                    for (size_t first = 0; first < used; first += chunk_size) {
+                        if (pool.change_ticks.chunks[first / 64] < buffer.tick) continue;
+                        const size_t bytes = std::min(chunk_size, used - first) * sizeof(Node);
+                        std::memcpy(static_cast<void*>(dst + first), pool.nodes + first, bytes);
+                    }
+                }
+                buffer.source = &pool;
+                buffer.version = pool.structural_version_;
+                buffer.tick = pool.change_ticks.current;
+            }
+            if (compare) {
+                for (size_t first = 0; first < used; first += chunk_size) {
+                    const size_t bytes = std::min(chunk_size, used - first) * sizeof(Node);
+                    if (std::memcmp(dst + first, pool.nodes + first, bytes) != 0) {
+                        std::memcpy(static_cast<void*>(dst + first), pool.nodes + first, bytes);
+                    }
+                }
+            }
+
+            buffer.high_water = pool.high_water;
+            buffer.sequence = ++published;
+            latest.store(target);
+        }
+
+        // Reader threads. Each reader holds at most one ReadView at a time.
+        ReadView acquire() {
+            for (;;) {
+                const uint32_t idx = latest.load();
+                readers[idx].fetch_add(1);
+                if (latest.load() == idx) return ReadView(this, idx);
+                readers[idx].fetch_sub(1);
+            }
+        }
+
+        uint64_t publish_count() const { return published; }
+    };
+
+    // --- Interest Management ---
+    export struct GridPoint {
+        float x = 0.0f;
+        float y = 0.0f;
+    };
+
+    // Uniform spatial hash over active slots, rebuilt once per tick and shared by all observers.
+    export template <size_t MAX_THINGS, size_t CELL_BUCKETS = 4096>
+    class InterestGrid {
+        static_assert(CELL_BUCKETS > 0 && (CELL_BUCKETS & (CELL_BUCKETS - 1)) == 0,
+                      "InterestGrid requires a power-of-two CELL_BUCKETS.");
+
+        static constexpr size_t max_query_cells = 64;
+
+        float inv_cell_size;
+        GridPoint positions[MAX_THINGS] = {};
+        SlotBitmap<MAX_THINGS> indexed;
+        ThingIdx bucket_start[CELL_BUCKETS + 1] = {};
+        ThingIdx bucket_items[MAX_THINGS] = {};
+
+        int32_t cell_coord(float v) const {
+            const float cell = std::floor(v * inv_cell_size);
+            return static_cast<int32_t>(std::clamp(cell, -1073741824.0f, 1073741824.0f));
+        }
+
+        static size_t bucket_of(int32_t cx, int32_t cy) {
+            const uint32_t h = (static_cast<uint32_t>(cx) * 73856093u) ^ (static_cast<uint32_t>(cy) * 19349663u);
+            return h & (CELL_BUCKETS - 1);
+        }
+
+        size_t bucket_of(GridPoint p) const { return bucket_of(cell_coord(p.x), cell_coord(p.y)); }
+
+    public:
+        explicit InterestGrid(float cell_size) : inv_cell_size(1.0f / cell_size) {
+            assert(cell_size > 0.0f && "InterestGrid requires a positive cell size.");
+        }
+
+        template <typename T, typename Policy, typename PositionFn>
+        void rebuild(ThingPool<T, MAX_THINGS, Policy>& pool, PositionFn&& position) {
+            indexed.clear();
+            std::fill_n(bucket_start, CELL_BUCKETS + 1, ThingIdx{0});
+            ThingIdx total = 0;
+            for (auto item : pool) {
+                const GridPoint p = position(item.data);
+                positions[item.ref.index] = p;
+                indexed.set(item.ref.index);
+                bucket_start[bucket_of(p)]++;
+                total++;
+            }
+
+            // Counting sort: prefix sums give bucket ends, filling backwards turns them into starts.
+            for (size_t b = 1; b < CELL_BUCKETS; ++b) bucket_start[b] += bucket_start[b - 1];
+            bucket_start[CELL_BUCKETS] = total;
+            indexed.for_each([&](ThingIdx idx) {
+                bucket_items[--bucket_start[bucket_of(positions[idx])]] = idx;
+            });
+        }
+
+        bool contains(ThingIdx idx) const { return idx < MAX_THINGS && indexed.test(idx); }
+        GridPoint position(ThingIdx idx) const { return positions[idx]; }
+
+        // Calls fn(ThingIdx, float distance_squared) once for every indexed slot within radius.
+        template <typename Fn>
+        void query(GridPoint center, float radius, Fn&& fn) const {
+            const float radius_sq = radius * radius;
+            auto visit_bucket = [&](size_t b) {
+                for (ThingIdx i = bucket_start[b]; i < bucket_start[b + 1]; ++i) {
+                    const ThingIdx idx = bucket_items[i];
+                    const float dx = positions[idx].x - center.x;
+                    const float dy = positions[idx].y - center.y;
+                    const float dist_sq = dx * dx + dy * dy;
+                    if (dist_sq <= radius_sq) fn(idx, dist_sq);
+                }
+            };
+
+            const int32_t x0 = cell_coord(center.x - radius);
+            const int32_t x1 = cell_coord(center.x + radius);
+            const int32_t y0 = cell_coord(center.y - radius);
+            const int32_t y1 = cell_coord(center.y + radius);
+            const uint64_t cells = static_cast<uint64_t>(int64_t{x1} - x0 + 1) * static_cast<uint64_t>(int64_t{y1} - y0 + 1);
+            if (cells > max_query_cells) {
+                for (size_t b = 0; b < CELL_BUCKETS; ++b) visit_bucket(b);
+                return;
+            }
+
+            // Distinct cells can hash to one bucket; visit each bucket once.
+            size_t visited[max_query_cells];
+            size_t visited_count = 0;
+            for (int32_t cy = y0; cy <= y1; ++cy) {
+                for (int32_t cx = x0; cx <= x1; ++cx) {
+                    const size_t b = bucket_of(cx, cy);
+                    if (std::find(visited, visited + visited_count, b) != visited + visited_count) continue;
+                    visited[visited_count++] = b;
+                    visit_bucket(b);
+                }
+            }
+        }
+    };
+
+    // Per-client relevant slot set with enter/leave hysteresis.
+    export template <size_t MAX_THINGS>
+    class RelevanceFilter {
+        SlotBitmap<MAX_THINGS> sets[2];
+        unsigned current = 0;
+        float enter_radius;
+        float leave_radius;
+
+    public:
+        RelevanceFilter(float enter_radius, float leave_radius)
+            : enter_radius(enter_radius), leave_radius(std::max(enter_radius, leave_radius)) {}
+
+        template <typename T, typename Policy, size_t CELL_BUCKETS>
+        void update(const ThingPool<T, MAX_THINGS, Policy>& pool, const InterestGrid<MAX_THINGS, CELL_BUCKETS>& grid,
+                    ThingRef observer) {
+            current ^= 1;
+            SlotBitmap<MAX_THINGS>& now = sets[current];
+            const SlotBitmap<MAX_THINGS>& before = sets[current ^ 1];
+            now.clear();
+            if (!pool.is_valid(observer) || !grid.contains(observer.index)) return;
+
+            now.set(observer.index);
+            const float enter_sq = enter_radius * enter_radius;
+            grid.query(grid.position(observer.index), leave_radius, [&](ThingIdx idx, float dist_sq) {
+                if (dist_sq <= enter_sq || before.test(idx)) now.set(idx);
+            });
+        }
+
+        const SlotBitmap<MAX_THINGS>& relevant() const { return sets[current]; }
+        bool is_relevant(ThingIdx idx) const { return idx < MAX_THINGS && sets[current].test(idx); }
+
+        template <typename Fn>
+        void for_each_entered(Fn&& fn) const { for_each_difference(sets[current], sets[current ^ 1], fn); }
+
+        template <typename Fn>
+        void for_each_left(Fn&& fn) const { for_each_difference(sets[current ^ 1], sets[current], fn); }
+
+    private:
+        template <typename Fn>
+        static void for_each_difference(const SlotBitmap<MAX_THINGS>& in, const SlotBitmap<MAX_THINGS>& out, Fn& fn) {
+            for (size_t w = 0; w < SlotBitmap<MAX_THINGS>::word_count; ++w) {
+                for (uint64_t bits = in.word(w) & ~out.word(w); bits != 0; bits &= bits - 1) {
+                    fn(static_cast<ThingIdx>(w * 64 + static_cast<size_t>(std::countr_zero(bits))));
+                }
             }
-            return false;
         }
     };
 
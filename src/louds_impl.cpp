@@ -1,17 +1,67 @@
 module;
 
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <span>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 
 // Declare that this file implements the 'louds' module.
 module louds; 
 
+namespace louds {
+
+    EpochDomain::Guard EpochDomain::pin(size_t reader_slot) {
+        assert(reader_slot < max_readers && "EpochDomain::pin reader slot out of range.");
+        std::atomic<uint64_t>& pinned = readers[reader_slot].epoch;
+        assert(pinned.load() == idle && "EpochDomain::pin reader slot is already pinned.");
+
+        uint64_t epoch = global_epoch.load();
+        for (;;) {
+            pinned.store(epoch);
+            const uint64_t current = global_epoch.load();
+            if (current == epoch) break;
+            epoch = current;
+        }
+        return Guard(this, reader_slot);
+    }
+
+    void EpochDomain::unpin(size_t reader_slot) {
+        readers[reader_slot].epoch.store(idle);
+    }
+
+    bool EpochDomain::try_advance() {
+        uint64_t epoch = global_epoch.load();
+        for (const ReaderSlot& reader : readers) {
+            const uint64_t pinned = reader.epoch.load();
+            if (pinned != idle && pinned != epoch) return false;
+        }
+        return global_epoch.compare_exchange_strong(epoch, epoch + 1);
+    }
+
+    uint64_t EpochDomain::epoch() const {
+        return global_epoch.load();
+    }
+
+} // namespace louds
+
 // Placed directly into the nested namespace
 namespace louds::detail {
 
-    bool write_pool_to_disk(const char* filepath, const void* header, size_t header_size, 
-                            const void* next_free, size_t free_size, 
-                            const void* nodes, size_t nodes_size) {
+    bool write_file_sections(const char* filepath, std::span<const FileSection> sections) {
         
         std::ofstream out(filepath, std::ios::binary);
         if (!out) {
@@ -19,16 +69,14 @@ namespace louds::detail {
             return false;
         }
 
-        out.write(reinterpret_cast<const char*>(header), header_size);
-        out.write(reinterpret_cast<const char*>(next_free), free_size);
-        out.write(reinterpret_cast<const char*>(nodes), nodes_size);
+        for (const FileSection& section : sections) {
+            out.write(reinterpret_cast<const char*>(section.data), static_cast<std::streamsize>(section.size));
+        }
 
         return out.good();
     }
 
-    bool read_pool_from_disk(const char* filepath, void* header, size_t header_size, 
-                             void* next_free, size_t free_size, 
-                             void* nodes, size_t nodes_size) {
+    bool read_file_sections(const char* filepath, size_t offset, std::span<const FileSpan> sections) {
         
         std::ifstream in(filepath, std::ios::binary);
         if (!in) {
@@ -36,13 +84,243 @@ namespace louds::detail {
             return false;
         }
 
-        in.read(reinterpret_cast<char*>(header), header_size);
-        if (in.gcount() != static_cast<std::streamsize>(header_size)) return false;
-
-        in.read(reinterpret_cast<char*>(next_free), free_size);
-        in.read(reinterpret_cast<char*>(nodes), nodes_size);
+        in.seekg(static_cast<std::streamoff>(offset));
+        for (const FileSpan& section : sections) {
+            in.read(reinterpret_cast<char*>(section.data), static_cast<std::streamsize>(section.size));
+            if (in.gcount() != static_cast<std::streamsize>(section.size)) return false;
+        }
 
         return in.good();
     }
 
+#if defined(_WIN32)
+
+    bool create_shared_region(size_t size, SharedRegion& region) {
+        const auto size64 = static_cast<unsigned long long>(size);
+        HANDLE mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                                            static_cast<DWORD>(size64 >> 32),
+                                            static_cast<DWORD>(size64 & 0xFFFFFFFFu), nullptr);
+        if (mapping == nullptr) {
+            std::cerr << "[LOUDS ERROR] Failed to create shared pool mapping of " << size << " bytes\n";
+            return false;
+        }
+        void* address = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+        if (address == nullptr) {
+            std::cerr << "[LOUDS ERROR] Failed to map shared pool memory\n";
+            CloseHandle(mapping);
+            return false;
+        }
+        region.address = address;
+        region.size = size;
+        region.handle = reinterpret_cast<intptr_t>(mapping);
+        return true;
+    }
+
+    void destroy_shared_region(SharedRegion& region) {
+        if (region.address) UnmapViewOfFile(region.address);
+        if (region.handle != -1) CloseHandle(reinterpret_cast<HANDLE>(region.handle));
+        region = {};
+    }
+
+    void* map_private_copy(const SharedRegion& region) {
+        void* address = MapViewOfFile(reinterpret_cast<HANDLE>(region.handle), FILE_MAP_COPY, 0, 0, region.size);
+        if (address == nullptr) {
+            std::cerr << "[LOUDS ERROR] Failed to map copy-on-write pool fork\n";
+        }
+        return address;
+    }
+
+    void unmap_private_copy(void* address, size_t) {
+        UnmapViewOfFile(address);
+    }
+
+    bool remap_private(const SharedRegion& region) {
+        // Windows cannot replace a view in place; the address is re-taken right after it is freed.
+        UnmapViewOfFile(region.address);
+        void* address = MapViewOfFileEx(reinterpret_cast<HANDLE>(region.handle), FILE_MAP_COPY, 0, 0,
+                                        region.size, region.address);
+        if (address == nullptr) {
+            std::cerr << "[LOUDS ERROR] Failed to remap forkable pool copy-on-write\n";
+            return false;
+        }
+        return true;
+    }
+
+    void close_region_handle(SharedRegion& region) {
+        if (region.handle != -1) CloseHandle(reinterpret_cast<HANDLE>(region.handle));
+        region.handle = -1;
+    }
+
+#else
+
+    namespace {
+
+        int open_anonymous_file() {
+#if defined(__linux__)
+            return memfd_create("louds_pool", MFD_CLOEXEC);
+#else
+            static std::atomic<unsigned> counter{0};
+            char name[64];
+            std::snprintf(name, sizeof(name), "/louds_pool_%ld_%u", static_cast<long>(getpid()), counter++);
+            const int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+            if (fd >= 0) shm_unlink(name);
+            return fd;
+#endif
+        }
+
+    } // namespace
+
+    bool create_shared_region(size_t size, SharedRegion& region) {
+        const int fd = open_anonymous_file();
+        if (fd < 0) {
+            std::cerr << "[LOUDS ERROR] Failed to create shared pool memory\n";
+            return false;
+        }
+        if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            std::cerr << "[LOUDS ERROR] Failed to size shared pool memory to " << size << " bytes\n";
+            close(fd);
+            return false;
+        }
+        void* address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (address == MAP_FAILED) {
+            std::cerr << "[LOUDS ERROR] Failed to map shared pool memory\n";
+            close(fd);
+            return false;
+        }
+        region.address = address;
+        region.size = size;
+        region.handle = fd;
+        return true;
+    }
+
+    void destroy_shared_region(SharedRegion& region) {
+        if (region.address) munmap(region.address, region.size);
+        if (region.handle != -1) close(static_cast<int>(region.handle));
+        region = {};
+    }
+
+    void* map_private_copy(const SharedRegion& region) {
+        void* address = mmap(nullptr, region.size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                             static_cast<int>(region.handle), 0);
+        if (address == MAP_FAILED) {
+            std::cerr << "[LOUDS ERROR] Failed to map copy-on-write pool fork\n";
+            return nullptr;
+        }
+        return address;
+    }
+
+    void unmap_private_copy(void* address, size_t size) {
+        munmap(address, size);
+    }
+
+    bool remap_private(const SharedRegion& region) {
+        void* address = mmap(region.address, region.size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED,
+                             static_cast<int>(region.handle), 0);
+        if (address == MAP_FAILED) {
+            std::cerr << "[LOUDS ERROR] Failed to remap forkable pool copy-on-write\n";
+            return false;
+        }
+        return true;
+    }
+
+    void close_region_handle(SharedRegion& region) {
+        if (region.handle != -1) close(static_cast<int>(region.handle));
+        region.handle = -1;
+    }
+
+#endif
+
+    namespace {
+
+        void put_byte(ByteWriter& out, uint8_t value) {
+            if (out.size >= out.capacity) {
+                out.overflow = true;
+                return;
+            }
+            out.data[out.size++] = value;
+        }
+
+        uint64_t load_word(const uint8_t* bytes) {
+            uint64_t word = 0;
+            std::memcpy(&word, bytes, sizeof(word));
+            return word;
+        }
+
+    } // namespace
+
+    void write_varint(ByteWriter& out, uint64_t value) {
+        while (value >= 0x80) {
+            put_byte(out, static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        put_byte(out, static_cast<uint8_t>(value));
+    }
+
+    bool read_varint(ByteReader& in, uint64_t& value) {
+        value = 0;
+        for (unsigned shift = 0; shift < 64; shift += 7) {
+            if (in.offset >= in.size) return false;
+            const uint8_t byte = in.data[in.offset++];
+            value |= uint64_t{byte & 0x7Fu} << shift;
+            if ((byte & 0x80) == 0) return true;
+        }
+        return false;
+    }
+
+    void write_xor_runs(ByteWriter& out, const void* current, const void* baseline, size_t size) {
+        const auto* cur = static_cast<const uint8_t*>(current);
+        const auto* base = static_cast<const uint8_t*>(baseline);
+        auto diff_at = [&](size_t i) -> uint8_t {
+            return base ? static_cast<uint8_t>(cur[i] ^ base[i]) : cur[i];
+        };
+
+        size_t offset = 0;
+        while (offset < size) {
+            size_t end = offset;
+            while (end + sizeof(uint64_t) <= size &&
+                   (load_word(cur + end) ^ (base ? load_word(base + end) : 0)) == 0) {
+                end += sizeof(uint64_t);
+            }
+            while (end < size && diff_at(end) == 0) end++;
+            write_varint(out, end - offset);
+            offset = end;
+            if (offset == size) break;
+
+            // Absorb single-byte zero gaps into the literal; a new run pair would cost more.
+            while (end < size) {
+                if (diff_at(end) != 0) {
+                    end++;
+                    continue;
+                }
+                size_t gap = 0;
+                while (end + gap < size && diff_at(end + gap) == 0) gap++;
+                if (gap >= 2 || end + gap == size) break;
+                end += gap;
+            }
+            write_varint(out, end - offset);
+            for (; offset < end; ++offset) put_byte(out, diff_at(offset));
+        }
+    }
+
+    bool read_xor_runs(ByteReader& in, void* target, size_t size) {
+        auto* bytes = static_cast<uint8_t*>(target);
+        size_t offset = 0;
+        while (offset < size) {
+            uint64_t zeros = 0;
+            if (!read_varint(in, zeros) || zeros > size - offset) return false;
+            offset += static_cast<size_t>(zeros);
+            if (offset == size) break;
+
+            uint64_t literals = 0;
+            if (!read_varint(in, literals) || literals == 0 || literals > size - offset) return false;
+            if (literals > in.size - in.offset) return false;
+            if (bytes) {
+                for (size_t i = 0; i < literals; ++i) bytes[offset + i] ^= in.data[in.offset + i];
+            }
+            in.offset += static_cast<size_t>(literals);
+            offset += static_cast<size_t>(literals);
+        }
+        return true;
+    }
+
 } // namespace louds::detail
\ No newline at end of file
@@ -1,9 +1,17 @@
 #include <cstdint>
 #include <cstddef>
 #include <filesystem>
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
 #include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
 #include <type_traits>
+#include <vector>
 
 #include <doctest/doctest.h>
 
@@ -31,6 +39,210 @@ struct GameThing {
 
 static_assert(std::is_trivially_copyable_v<GameThing>);
 
+struct TwoBitGenerations : louds::DefaultPoolPolicy {
+    static constexpr unsigned generation_bits = 2;
+};
+
+struct DeepPrefetch : louds::DefaultPoolPolicy {
+    static constexpr size_t scan_prefetch_distance = 16;
+    static constexpr size_t hierarchy_lookahead = 6;
+};
+
+struct IntrusiveFreeList : louds::DefaultPoolPolicy {
+    static constexpr bool intrusive_free_list = true;
+    static constexpr size_t max_pending_destroy = 4;
+};
+
+struct NoPrefetch : louds::DefaultPoolPolicy {
+    static constexpr size_t scan_prefetch_distance = 0;
+    static constexpr size_t hierarchy_lookahead = 0;
+    static constexpr size_t batch_prefetch_distance = 0;
+};
+
+struct EagerScrub : louds::DefaultPoolPolicy {
+    static constexpr louds::ScrubPolicy scrub = louds::ScrubPolicy::eager;
+};
+
+struct NoScrub : louds::DefaultPoolPolicy {
+    static constexpr louds::ScrubPolicy scrub = louds::ScrubPolicy::none;
+};
+
+struct LocalityBitmap : louds::DefaultPoolPolicy {
+    static constexpr bool locality_bitmap = true;
+};
+
+struct IntrusiveLocality : IntrusiveFreeList {
+    static constexpr bool locality_bitmap = true;
+};
+
+template <typename Policy>
+void check_locality_spawns() {
+    louds::ThingPool<GameThing, 512, Policy> world;
+    std::vector<louds::ThingRef> refs{louds::NilRef};
+    for (int i = 1; i < 300; ++i) refs.push_back(world.spawn());
+    for (const int idx : {10, 100, 103, 250, 290}) world.destroy(refs[idx]);
+
+    // The LIFO head is slot 290; spawn_near() picks the closest free slot to the hint instead.
+    CHECK(world.spawn_near(refs[98]).index == 100);
+    CHECK(world.spawn_near(refs[104]).index == 103);
+    CHECK(world.spawn_near(refs[30]).index == 10);
+    const auto parent = refs[255];
+    const auto child = world.spawn_child(parent);
+    CHECK(child.index == 250);
+    CHECK(world.spawn_child(parent).index == 290);
+    CHECK_FALSE(world.spawn_child(child).index == 0);
+    CHECK(world.spawn_child(refs[10]) == louds::NilRef);
+
+    // Nothing free nearby: the hint only pulls from the high-water mark when it is in the same page region.
+    const auto far = world.spawn_near(refs[1]);
+    CHECK(far.index >= 300);
+
+    // The free-list stays consistent for plain spawn() after being cut in the middle.
+    std::vector<bool> seen(512, false);
+    for (const auto item : world) seen[item.ref.index] = true;
+    size_t spawned = 0;
+    while (const auto ref = world.spawn()) {
+        CHECK_FALSE(seen[ref.index]);
+        seen[ref.index] = true;
+        spawned++;
+    }
+    CHECK(world.stats().live_count == 511);
+
+    // Bits left over from before clear() are ignored.
+    world.clear();
+    const auto first = world.spawn_near(louds::ThingRef{200, 0});
+    CHECK(first.index == 1);
+    CHECK(world.spawn_near(first).index == 2);
+}
+
+struct Tags32 : louds::DefaultPoolPolicy {
+    static constexpr unsigned tag_bits = 32;
+};
+
+struct Tags64 : louds::DefaultPoolPolicy {
+    static constexpr unsigned tag_bits = 64;
+};
+
+struct ChangeTicks : louds::DefaultPoolPolicy {
+    static constexpr bool change_ticks = true;
+};
+
+struct LifecycleLog {
+    std::vector<std::vector<louds::ThingRef>> spawned;
+    std::vector<std::vector<louds::ThingRef>> destroyed;
+    size_t resets = 0;
+
+    void on_spawn(std::span<const louds::ThingRef> refs) { spawned.emplace_back(refs.begin(), refs.end()); }
+    void on_destroy(std::span<const louds::ThingRef> refs) { destroyed.emplace_back(refs.begin(), refs.end()); }
+    void on_reset() { resets++; }
+};
+
+struct LoggedLifecycle : louds::DefaultPoolPolicy {
+    using hooks = LifecycleLog;
+};
+
+struct SpawnCounter {
+    static inline size_t spawned = 0;
+    void on_spawn(std::span<const louds::ThingRef> refs) { spawned += refs.size(); }
+};
+
+struct CountedSpawns : louds::DefaultPoolPolicy {
+    using hooks = SpawnCounter;
+};
+
+namespace tag {
+constexpr std::uint32_t visible = 1u << 0;
+constexpr std::uint32_t burning = 1u << 1;
+constexpr std::uint32_t sleeping = 1u << 2;
+}
+
+template <typename Policy>
+void check_tag_queries() {
+    using World = louds::ThingPool<GameThing, 256, Policy>;
+    World world;
+    std::vector<louds::ThingRef> refs;
+    for (int i = 0; i < 203; ++i) {
+        const auto ref = world.spawn_with(GameThing{.health = i});
+        refs.push_back(ref);
+        CHECK(world.tags(ref) == 0);
+        if (i % 2 == 0) world.add_tags(ref, tag::visible);
+        if (i % 3 == 0) world.add_tags(ref, tag::burning);
+        if (i % 5 == 0) world.set_tags(ref, world.tags(ref) | tag::sleeping);
+    }
+    world.remove_tags(refs[30], tag::sleeping);
+    world.destroy(refs[60]);
+    CHECK(world.tags(refs[60]) == 0);
+
+    std::vector<int> seen;
+    world.for_tags(tag::visible | tag::burning, tag::sleeping, [&](louds::ThingRef ref, GameThing& thing) {
+        CHECK(world.is_valid(ref));
+        seen.push_back(thing.health);
+    });
+    std::vector<int> expected;
+    for (int i = 0; i < 203; ++i) {
+        if (i == 60) continue;
+        if (i % 6 == 0 && (i % 5 != 0 || i == 30)) expected.push_back(i);
+    }
+    CHECK(seen == expected);
+
+    // The reserved top bit is ignored, and none_of = 0 with all_of = 0 visits every live thing.
+    world.set_tags(refs[1], ~typename World::TagMask{0});
+    CHECK(world.tags(refs[1]) == World::user_tags);
+    size_t live = 0;
+    world.view().for_tags(0, 0, [&](louds::ThingRef, GameThing&) { live++; });
+    CHECK(live == 202);
+
+    // Retagging later slots of the current group from inside fn is honoured.
+    size_t sleepers = 0;
+    world.for_tags(tag::sleeping, 0, [&](louds::ThingRef, GameThing&) {
+        sleepers++;
+        for (const auto ref : refs) world.remove_tags(ref, tag::sleeping);
+    });
+    CHECK(sleepers == 1);
+}
+
+template <typename Pool>
+concept HasHierarchy = requires(Pool& pool, louds::ThingRef ref) {
+    pool.attach_child(ref, ref);
+    pool.detach(ref);
+};
+
+template <typename Policy>
+void check_prefetch_policy_walks() {
+    louds::ThingPool<GameThing, 512, Policy> world;
+    const auto root = world.spawn();
+    for (int bag = 0; bag < 10; ++bag) {
+        const auto container = world.spawn();
+        world.attach_child(root, container);
+        for (int item = 0; item < 20; ++item) {
+            const auto thing = world.spawn();
+            world.get(thing).kind = ThingKind::pickup;
+            world.attach_child(container, thing);
+        }
+    }
+    auto chain = world.spawn();
+    world.attach_child(root, chain);
+    for (int depth = 0; depth < 100; ++depth) {
+        const auto next = world.spawn();
+        world.attach_child(chain, next);
+        chain = next;
+    }
+    const auto bystander = world.spawn();
+
+    size_t items = 0;
+    world.for_kind(ThingKind::pickup, [&](louds::ThingRef, GameThing&) { items++; });
+    CHECK(items == 200);
+
+    size_t iterated = 0;
+    for (auto item : world) { (void)item; iterated++; }
+    CHECK(iterated == world.stats().live_count);
+
+    world.destroy(root);
+    CHECK(world.stats().live_count == 1);
+    CHECK(world.is_valid(bystander));
+    CHECK_FALSE(world.is_valid(chain));
+}
+
 void simulate_motion_step(louds::ThingPool<GameThing, 32>& pool, float dt) {
     for (auto item : pool) {
         auto& thing = item.data;
@@ -72,6 +284,15 @@ void cleanup_dead_enemies(louds::ThingPool<GameThing, MAX_THINGS>& world) {
     });
 }
 
+float total_health(louds::PoolView<const GameThing, 64> view) {
+    float total = 0.0f;
+    for (auto item : view) {
+        static_assert(std::is_same_v<decltype(item.data), const GameThing&>);
+        total += static_cast<float>(item.data.health);
+    }
+    return total;
+}
+
 } // namespace
 
 TEST_CASE("ThingRef basics") {
@@ -688,3 +909,1828 @@ TEST_CASE("for_kind dispatch pattern skips elements with wrong kind") {
     });
     CHECK(const_enemy_count == 1);
 }
+
+TEST_CASE("delta replication loopback mirrors spawns, changes and destroys") {
+    using World = louds::ThingPool<GameThing, 32>;
+    World server;
+    World client;
+    louds::ReplicationBaseline<GameThing, 32> baseline;
+    std::vector<std::uint8_t> packet(World::max_delta_size());
+
+    const auto player = server.spawn();
+    const auto enemy = server.spawn();
+    const auto weapon = server.spawn();
+    server.get(player) = {.kind = ThingKind::player, .px = 1.0f, .health = 100};
+    server.get(enemy) = {.kind = ThingKind::enemy, .px = 9.0f, .health = 40, .target = player};
+    server.get(weapon).kind = ThingKind::pickup;
+    server.attach_child(player, weapon);
+
+    CHECK(baseline.needs_full_resync());
+    auto size = server.encode_delta(baseline, packet);
+    REQUIRE(size > 0);
+    CHECK_FALSE(baseline.needs_full_resync());
+    REQUIRE(client.apply_delta({packet.data(), size}));
+
+    REQUIRE(client.is_valid(player));
+    REQUIRE(client.is_valid(enemy));
+    REQUIRE(client.is_valid(weapon));
+    CHECK(client.get(enemy).target == player);
+    CHECK(client.get(player).health == 100);
+
+    server.get(enemy).px = 10.0f;
+    server.destroy(player);
+    const auto projectile = server.spawn();
+    server.get(projectile) = {.kind = ThingKind::projectile, .vx = 5.0f, .target = enemy};
+
+    size = server.encode_delta(baseline, packet);
+    REQUIRE(size > 0);
+    REQUIRE(client.apply_delta({packet.data(), size}));
+
+    CHECK_FALSE(client.is_valid(player));
+    CHECK_FALSE(client.is_valid(weapon));
+    CHECK(client.get(enemy).px == doctest::Approx(10.0f));
+    REQUIRE(client.is_valid(projectile));
+    CHECK(client.get(projectile).target == enemy);
+
+    int client_count = 0;
+    for (auto item : client) {
+        (void)item;
+        client_count++;
+    }
+    CHECK(client_count == 2);
+
+    // The replica's free list is rebuilt, so local spawns never overwrite replicated slots.
+    const auto local = client.spawn();
+    REQUIRE(client.is_valid(local));
+    CHECK(local.index != enemy.index);
+    CHECK(local.index != projectile.index);
+}
+
+TEST_CASE("delta replication sends nothing for unchanged slots and rejects malformed streams") {
+    using World = louds::ThingPool<GameThing, 16>;
+    World server;
+    World client;
+    louds::ReplicationBaseline<GameThing, 16> baseline;
+    std::vector<std::uint8_t> packet(World::max_delta_size());
+
+    const auto enemy = server.spawn();
+    server.get(enemy) = {.kind = ThingKind::enemy, .health = 40};
+    REQUIRE(client.apply_delta({packet.data(), server.encode_delta(baseline, packet)}));
+
+    const auto idle_size = server.encode_delta(baseline, packet);
+    CHECK(idle_size == 3);
+    REQUIRE(client.apply_delta({packet.data(), idle_size}));
+
+    server.get(enemy).health = 39;
+    const auto size = server.encode_delta(baseline, packet);
+    REQUIRE(size > idle_size);
+    CHECK(size < sizeof(GameThing));
+
+    CHECK_FALSE(client.apply_delta({packet.data(), size - 1}));
+    CHECK(client.get(enemy).health == 40);
+
+    std::vector<std::uint8_t> garbage(packet.begin(), packet.begin() + static_cast<std::ptrdiff_t>(size));
+    garbage.push_back(0xFF);
+    CHECK_FALSE(client.apply_delta(garbage));
+    CHECK(client.get(enemy).health == 40);
+
+    REQUIRE(client.apply_delta({packet.data(), size}));
+    CHECK(client.get(enemy).health == 39);
+
+    server.get(enemy).health = 38;
+    std::array<std::uint8_t, 4> tiny{};
+    CHECK(server.encode_delta(baseline, tiny) == 0);
+    CHECK(baseline.needs_full_resync());
+}
+
+TEST_CASE("relevance filter keeps nearby slots with enter/leave hysteresis") {
+    using World = louds::ThingPool<GameThing, 32>;
+    World world;
+    louds::InterestGrid<32, 64> grid(10.0f);
+    louds::RelevanceFilter<32> filter(20.0f, 30.0f);
+    const auto position = [](const GameThing& thing) { return louds::GridPoint{thing.px, thing.py}; };
+
+    const auto observer = world.spawn();
+    const auto near = world.spawn();
+    const auto drifting = world.spawn();
+    const auto far = world.spawn();
+    world.get(observer) = {.kind = ThingKind::player};
+    world.get(near) = {.kind = ThingKind::enemy, .px = 5.0f};
+    world.get(drifting) = {.kind = ThingKind::enemy, .px = 15.0f, .py = 5.0f};
+    world.get(far) = {.kind = ThingKind::pickup, .px = -200.0f, .py = 90.0f};
+
+    grid.rebuild(world, position);
+    filter.update(world, grid, observer);
+    CHECK(filter.is_relevant(observer.index));
+    CHECK(filter.is_relevant(near.index));
+    CHECK(filter.is_relevant(drifting.index));
+    CHECK_FALSE(filter.is_relevant(far.index));
+    CHECK(filter.relevant().count() == 3);
+
+    int entered = 0;
+    filter.for_each_entered([&](louds::ThingIdx) { entered++; });
+    CHECK(entered == 3);
+
+    // Between the enter and leave radius: stays relevant because it already was.
+    world.get(drifting).px = 25.0f;
+    grid.rebuild(world, position);
+    filter.update(world, grid, observer);
+    CHECK(filter.is_relevant(drifting.index));
+
+    // A slot that was never relevant needs to cross the enter radius.
+    world.get(far) = {.kind = ThingKind::pickup, .px = 0.0f, .py = 25.0f};
+    grid.rebuild(world, position);
+    filter.update(world, grid, observer);
+    CHECK_FALSE(filter.is_relevant(far.index));
+
+    world.get(drifting).px = 40.0f;
+    grid.rebuild(world, position);
+    filter.update(world, grid, observer);
+    CHECK_FALSE(filter.is_relevant(drifting.index));
+
+    std::vector<louds::ThingIdx> left;
+    filter.for_each_left([&](louds::ThingIdx idx) { left.push_back(idx); });
+    REQUIRE(left.size() == 1);
+    CHECK(left[0] == drifting.index);
+
+    world.destroy(observer);
+    filter.update(world, grid, observer);
+    CHECK(filter.relevant().count() == 0);
+}
+
+TEST_CASE("relevance-filtered replication only sends slots the client should see") {
+    using World = louds::ThingPool<GameThing, 32>;
+    World server;
+    World client;
+    louds::ReplicationBaseline<GameThing, 32> baseline;
+    louds::InterestGrid<32, 64> grid(10.0f);
+    louds::RelevanceFilter<32> filter(20.0f, 30.0f);
+    std::vector<std::uint8_t> packet(World::max_delta_size());
+    const auto position = [](const GameThing& thing) { return louds::GridPoint{thing.px, thing.py}; };
+
+    const auto observer = server.spawn();
+    const auto near = server.spawn();
+    const auto far = server.spawn();
+    server.get(observer).kind = ThingKind::player;
+    server.get(near) = {.kind = ThingKind::enemy, .px = 5.0f};
+    server.get(far) = {.kind = ThingKind::enemy, .px = 500.0f};
+
+    grid.rebuild(server, position);
+    filter.update(server, grid, observer);
+    auto size = server.encode_delta(baseline, packet, filter.relevant());
+    REQUIRE(client.apply_delta({packet.data(), size}));
+    CHECK(client.is_valid(observer));
+    CHECK(client.is_valid(near));
+    CHECK_FALSE(client.is_valid(far));
+
+    server.get(near).px = 100.0f;
+    server.get(far).px = 1.0f;
+    grid.rebuild(server, position);
+    filter.update(server, grid, observer);
+    size = server.encode_delta(baseline, packet, filter.relevant());
+    REQUIRE(client.apply_delta({packet.data(), size}));
+    CHECK_FALSE(client.is_valid(near));
+    REQUIRE(client.is_valid(far));
+    CHECK(client.get(far).px == doctest::Approx(1.0f));
+}
+
+TEST_CASE("relevance-filtered replication never sends links to slots the client lacks") {
+    using World = louds::ThingPool<GameThing, 32>;
+    World server;
+    World client;
+    louds::ReplicationBaseline<GameThing, 32> baseline;
+    std::vector<std::uint8_t> packet(World::max_delta_size());
+
+    const auto hidden_child = server.spawn();
+    const auto player = server.spawn();
+    const auto shown_a = server.spawn();
+    const auto shown_b = server.spawn();
+    const auto hidden_parent = server.spawn();
+    const auto orphan = server.spawn();
+    server.attach_child(player, hidden_child);
+    server.attach_child(player, shown_a);
+    server.attach_child(player, shown_b);
+    server.attach_child(hidden_parent, orphan);
+
+    louds::SlotBitmap<32> relevant;
+    for (const auto ref : {player, shown_a, shown_b, orphan}) relevant.set(ref.index);
+    auto size = server.encode_delta(baseline, packet, relevant);
+    REQUIRE(client.apply_delta({packet.data(), size}));
+
+    // The client's local spawn takes the hidden child's slot; destroying the replicated parent must
+    // only take its replicated children with it.
+    const auto local = client.spawn();
+    CHECK(local.index == hidden_child.index);
+    client.destroy(player);
+    CHECK(client.is_valid(local));
+    CHECK_FALSE(client.is_valid(shown_a));
+    CHECK_FALSE(client.is_valid(shown_b));
+    CHECK(client.is_valid(orphan));
+    client.destroy(orphan);
+    CHECK(client.stats().live_count == 1);
+
+    // Hiding a sibling later re-threads the ring the client holds.
+    World second;
+    louds::ReplicationBaseline<GameThing, 32> second_baseline;
+    size = server.encode_delta(second_baseline, packet, relevant);
+    REQUIRE(second.apply_delta({packet.data(), size}));
+    relevant.reset(shown_a.index);
+    size = server.encode_delta(second_baseline, packet, relevant);
+    REQUIRE(second.apply_delta({packet.data(), size}));
+    second.destroy(shown_b);
+    CHECK(second.is_valid(player));
+    second.destroy(player);
+    CHECK(second.stats().live_count == 1);
+}
+
+TEST_CASE("published read view is an immutable snapshot of the pool") {
+    using World = louds::ThingPool<GameThing, 16>;
+    World world;
+    louds::ViewPublisher<GameThing, 16> publisher;
+
+    const auto player = world.spawn();
+    const auto enemy = world.spawn();
+    world.get(player) = {.kind = ThingKind::player, .px = 1.0f};
+    world.get(enemy) = {.kind = ThingKind::enemy, .health = 10};
+    publisher.publish(world);
+
+    auto view = publisher.acquire();
+    CHECK(view.sequence() == 1);
+    REQUIRE(view.is_valid(player));
+    CHECK(view.get(player).px == doctest::Approx(1.0f));
+
+    // Simulation keeps mutating; the view held by the reader does not change.
+    world.get(player).px = 2.0f;
+    world.destroy(enemy);
+    publisher.publish(world);
+    CHECK(view.get(player).px == doctest::Approx(1.0f));
+    CHECK(view.is_valid(enemy));
+
+    int enemies = 0;
+    view.for_kind(ThingKind::enemy, [&](louds::ThingRef, const GameThing& thing) {
+        CHECK(thing.health == 10);
+        enemies++;
+    });
+    CHECK(enemies == 1);
+
+    view = publisher.acquire();
+    CHECK(view.sequence() == 2);
+    CHECK(view.get(player).px == doctest::Approx(2.0f));
+    CHECK_FALSE(view.is_valid(enemy));
+
+    int visible = 0;
+    for (auto item : view) {
+        CHECK(item.ref == player);
+        visible++;
+    }
+    CHECK(visible == 1);
+}
+
+TEST_CASE("stamped-only publishing copies only chunks with stamped changes") {
+    using World = louds::ThingPool<GameThing, 256, ChangeTicks>;
+    auto world = std::make_unique<World>();
+    using Publisher = louds::ViewPublisher<GameThing, 256, 1, ChangeTicks>;
+    auto publisher = std::make_unique<Publisher>(louds::PublishMode::stamped_only);
+
+    std::vector<louds::ThingRef> things;
+    for (int i = 0; i < 200; ++i) things.push_back(world->spawn());
+    world->advance_tick();
+    // Every buffer gets one full copy after the last structural change.
+    for (int i = 0; i < 3; ++i) publisher->publish(*world);
+
+    world->get_mut(things[10]).health = 7;
+    // Written without a stamp in another chunk: publish does not read that chunk.
+    world->get(things[150]).health = 9;
+    publisher->publish(*world);
+    {
+        const auto view = publisher->acquire();
+        CHECK(view.get(things[10]).health == 7);
+        CHECK(view.get(things[150]).health == 0);
+    }
+
+    // A structural change falls back to comparing bytes.
+    world->destroy(things[0]);
+    publisher->publish(*world);
+    const auto view = publisher->acquire();
+    CHECK_FALSE(view.is_valid(things[0]));
+    CHECK(view.get(things[10]).health == 7);
+    CHECK(view.get(things[150]).health == 9);
+
+    // By default a change-ticked pool is still compared byte for byte, so unstamped writes are published.
+    auto by_bytes = std::make_unique<Publisher>();
+    for (int i = 0; i < 3; ++i) by_bytes->publish(*world);
+    world->get(things[150]).health = 11;
+    by_bytes->publish(*world);
+    CHECK(by_bytes->acquire().get(things[150]).health == 11);
+}
+
+TEST_CASE("reader thread always sees consistent published state") {
+    using World = louds::ThingPool<GameThing, 64>;
+    auto world = std::make_unique<World>();
+    auto publisher = std::make_unique<louds::ViewPublisher<GameThing, 64>>();
+
+    const auto a = world->spawn();
+    const auto b = world->spawn();
+    world->get(a).health = 1000;
+    world->get(b).health = 0;
+    publisher->publish(*world);
+
+    std::atomic<bool> done{false};
+    std::atomic<int> inconsistent{0};
+    std::thread reader([&] {
+        while (!done.load()) {
+            const auto view = publisher->acquire();
+            if (view.get(a).health + view.get(b).health != 1000) inconsistent++;
+        }
+    });
+
+    for (int tick = 0; tick < 2000; ++tick) {
+        world->get(a).health -= 1;
+        world->get(b).health += 1;
+        publisher->publish(*world);
+    }
+    done.store(true);
+    reader.join();
+
+    CHECK(inconsistent.load() == 0);
+    CHECK(publisher->acquire().get(b).health == 2000);
+}
+
+TEST_CASE("forked pools share parent state and copy only on write") {
+    louds::ForkablePool<GameThing, 1024> world;
+    REQUIRE(world);
+
+    const auto player = world->spawn();
+    const auto enemy = world->spawn();
+    world->get(player) = {.kind = ThingKind::player, .health = 100};
+    world->get(enemy) = {.kind = ThingKind::enemy, .health = 100, .target = player};
+
+    auto attack = world.fork();
+    auto retreat = world.fork();
+    REQUIRE(attack);
+    REQUIRE(retreat);
+
+    attack->get(enemy).health -= 60;
+    attack->destroy(player);
+    const auto decoy = retreat->spawn();
+    REQUIRE(retreat->is_valid(decoy));
+    retreat->get(decoy).kind = ThingKind::pickup;
+
+    CHECK(world->get(enemy).health == 100);
+    CHECK(world->is_valid(player));
+    CHECK_FALSE(world->is_valid(decoy));
+
+    CHECK(attack->get(enemy).health == 40);
+    CHECK_FALSE(attack->is_valid(player));
+    CHECK_FALSE(attack->is_valid(decoy));
+
+    CHECK(retreat->get(enemy).health == 100);
+    CHECK(retreat->is_valid(player));
+
+    // Commit the chosen branch back into the parent.
+    *world = *attack;
+    attack.discard();
+    retreat.discard();
+    CHECK_FALSE(attack);
+    CHECK(world->get(enemy).health == 40);
+    CHECK_FALSE(world->is_valid(player));
+}
+
+TEST_CASE("forks keep their snapshot while the parent moves on") {
+    louds::ForkablePool<GameThing, 4096> world;
+    REQUIRE(world);
+    const auto player = world->spawn_with(GameThing{.kind = ThingKind::player, .health = 100});
+    const auto enemy = world->spawn_with(GameThing{.kind = ThingKind::enemy, .health = 100});
+
+    auto before = world.fork();
+    auto also_before = world.fork();
+    REQUIRE(before);
+    world->get(player).health = 50;
+    world->destroy(enemy);
+    std::vector<louds::ThingRef> wave(1000);
+    world->spawn_n(wave);
+
+    CHECK(before->get(player).health == 100);
+    CHECK(before->is_valid(enemy));
+    CHECK_FALSE(before->is_valid(wave.back()));
+    CHECK(also_before->stats().live_count == 2);
+
+    // A fork taken now sees the parent's current state, and the earlier ones still don't.
+    auto after = world.fork();
+    REQUIRE(after);
+    CHECK(after->get(player).health == 50);
+    CHECK_FALSE(after->is_valid(enemy));
+    CHECK(after->is_valid(wave.back()));
+    world->get(player).health = 10;
+    CHECK(after->get(player).health == 50);
+    CHECK(before->get(player).health == 100);
+
+    *world = *before;
+    before.discard();
+    also_before.discard();
+    CHECK(world->get(player).health == 100);
+    CHECK(std::as_const(world)->is_valid(enemy));
+    CHECK(after->stats().live_count == 1001);
+}
+
+template <typename Policy>
+void check_fork_after_write() {
+    louds::ForkablePool<GameThing, 8192, Policy> world;
+    REQUIRE(world);
+    auto& pool = world.pool();
+    std::vector<louds::ThingRef> refs;
+    for (int i = 0; i < 300; ++i) refs.push_back(pool.spawn());
+    for (const int i : {3, 70, 71, 200}) pool.destroy(refs[i]);
+    auto first = world.fork();
+    REQUIRE(first);
+
+    // Writes through a kept reference are seen by the next fork.
+    pool.get(refs[10]).health = 42;
+    pool.destroy(refs[11]);
+    auto second = world.fork();
+    REQUIRE(second);
+    CHECK(first->get(refs[10]).health == 0);
+    CHECK(first->is_valid(refs[11]));
+    CHECK(second->get(refs[10]).health == 42);
+    CHECK_FALSE(second->is_valid(refs[11]));
+
+    // Unchanged parent: the snapshot is reused.
+    const uint64_t version = std::as_const(world)->write_version();
+    auto third = world.fork();
+    CHECK(std::as_const(world)->write_version() == version);
+    CHECK(third->get(refs[10]).health == 42);
+
+    // Only the used slots were copied; the fork still fills every slot above them.
+    size_t spawned = 0;
+    while (second->spawn()) spawned++;
+    CHECK(spawned == 8191 - 295);
+    CHECK(second->stats().live_count == 8191);
+    CHECK(pool.stats().live_count == 295);
+}
+
+TEST_CASE("forks see parent writes made through a kept pool reference") {
+    check_fork_after_write<louds::DefaultPoolPolicy>();
+    check_fork_after_write<LocalityBitmap>();
+    check_fork_after_write<IntrusiveLocality>();
+    check_fork_after_write<Tags64>();
+    check_fork_after_write<ChangeTicks>();
+}
+
+TEST_CASE("forks can run speculative simulations in parallel") {
+    louds::ForkablePool<GameThing, 256> world;
+    REQUIRE(world);
+    const auto mover = world->spawn();
+    world->get(mover) = {.kind = ThingKind::enemy, .vx = 1.0f};
+
+    std::vector<louds::PoolFork<GameThing, 256>> branches;
+    for (int i = 0; i < 4; ++i) branches.push_back(world.fork());
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < 4; ++i) {
+        workers.emplace_back([&, i] {
+            auto& branch = *branches[static_cast<size_t>(i)];
+            for (int step = 0; step <= i; ++step) {
+                for (auto item : branch) item.data.px += item.data.vx;
+            }
+        });
+    }
+    for (auto& worker : workers) worker.join();
+
+    for (int i = 0; i < 4; ++i) {
+        CHECK(branches[static_cast<size_t>(i)]->get(mover).px == doctest::Approx(static_cast<float>(i + 1)));
+    }
+    CHECK(world->get(mover).px == doctest::Approx(0.0f));
+}
+
+TEST_CASE("epoch-pinned readers keep destroyed slots from being reused") {
+    louds::EpochDomain epochs;
+    louds::ThingPool<GameThing, 4> world;
+    world.set_epoch_domain(&epochs);
+
+    const auto enemy = world.spawn();
+    world.get(enemy) = {.kind = ThingKind::enemy, .health = 42};
+
+    auto guard = epochs.pin(0);
+    const GameThing* seen = world.get_pinned(guard, enemy);
+    REQUIRE(seen != nullptr);
+
+    world.destroy(enemy);
+    CHECK(world.get_pinned(guard, enemy) == nullptr);
+    CHECK(seen->health == 42);
+
+    // The destroyed slot stays retired while the reader is pinned, so the pool runs out instead.
+    const auto a = world.spawn();
+    const auto b = world.spawn();
+    CHECK(world.is_valid(a));
+    CHECK(world.is_valid(b));
+    CHECK(world.spawn() == louds::NilRef);
+    CHECK(seen->health == 42);
+
+    guard.release();
+    world.collect_retired();
+    const auto reused = world.spawn();
+    REQUIRE(world.is_valid(reused));
+    CHECK(reused.index == enemy.index);
+    CHECK_FALSE(world.is_valid(enemy));
+}
+
+TEST_CASE("spawning with nothing retired does not advance the epoch") {
+    louds::EpochDomain epochs;
+    louds::ThingPool<GameThing, 64> world;
+    world.set_epoch_domain(&epochs);
+
+    const uint64_t start = epochs.epoch();
+    for (int i = 0; i < 32; ++i) REQUIRE(world.is_valid(world.spawn()));
+    CHECK(epochs.epoch() == start);
+
+    // Once something is retired, an empty free-list collects it.
+    const auto enemy = world.spawn();
+    world.destroy(enemy);
+    CHECK(world.spawn().index == enemy.index);
+    CHECK(epochs.epoch() > start);
+}
+
+TEST_CASE("epoch-pinned reader threads resolve refs while the owner churns slots") {
+    constexpr size_t slots = 8;
+    auto epochs = std::make_unique<louds::EpochDomain>();
+    auto world = std::make_unique<louds::ThingPool<GameThing, 64>>();
+    world->set_epoch_domain(epochs.get());
+
+    std::array<std::atomic<std::uint64_t>, slots> published{};
+    auto pack = [](louds::ThingRef ref) { return (std::uint64_t{ref.generation} << 32) | ref.index; };
+
+    std::atomic<bool> done{false};
+    std::atomic<int> torn{0};
+    std::atomic<int> resolved{0};
+    std::vector<std::thread> readers;
+    for (size_t r = 0; r < 2; ++r) {
+        readers.emplace_back([&, r] {
+            while (!done.load()) {
+                const auto guard = epochs->pin(r);
+                for (auto& entry : published) {
+                    const std::uint64_t packed = entry.load(std::memory_order_acquire);
+                    const louds::ThingRef ref{static_cast<louds::ThingIdx>(packed & 0xFFFFFFFFu),
+                                              static_cast<louds::Generation>(packed >> 32)};
+                    const GameThing* thing = world->get_pinned(guard, ref);
+                    if (thing == nullptr) continue;
+                    if (thing->health != static_cast<std::int32_t>(ref.generation * 1000 + ref.index)) torn++;
+                    resolved++;
+                }
+            }
+        });
+    }
+
+    for (int tick = 0; tick < 5000 || (resolved.load() == 0 && tick < 50'000'000); ++tick) {
+        auto& entry = published[static_cast<size_t>(tick) % slots];
+        const std::uint64_t old = entry.load();
+        world->destroy({static_cast<louds::ThingIdx>(old & 0xFFFFFFFFu), static_cast<louds::Generation>(old >> 32)});
+
+        const auto ref = world->spawn();
+        if (ref) {
+            world->get(ref).health = static_cast<std::int32_t>(ref.generation * 1000 + ref.index);
+            entry.store(pack(ref), std::memory_order_release);
+        }
+        world->collect_retired();
+    }
+    done.store(true);
+    for (auto& reader : readers) reader.join();
+
+    CHECK(torn.load() == 0);
+    CHECK(resolved.load() > 0);
+}
+
+TEST_CASE("slots are retired instead of wrapping their generation") {
+    using Pool = louds::ThingPool<int, 3, TwoBitGenerations>;
+    static_assert(Pool::max_generation == 3);
+    Pool pool;
+
+    std::array<louds::ThingRef, 3> history{};
+    for (auto& ref : history) {
+        ref = pool.spawn();
+        REQUIRE(pool.is_valid(ref));
+        CHECK(ref.index == 1u);
+        pool.destroy(ref);
+    }
+    CHECK(history[2].generation == Pool::max_generation);
+    CHECK(pool.stats().retired_slots == 1);
+    CHECK(pool.stats().live_count == 0);
+
+    // Slot 1 is gone for good; only slot 2 is left.
+    const auto survivor = pool.spawn();
+    REQUIRE(pool.is_valid(survivor));
+    CHECK(survivor.index == 2u);
+    CHECK(pool.spawn() == louds::NilRef);
+    CHECK(pool.stats().live_count == 1);
+
+    for (const auto ref : history) {
+        CHECK_FALSE(pool.is_valid(ref));
+    }
+}
+
+TEST_CASE("pool stats track live slots across destroy and load") {
+    louds::ThingPool<std::int32_t, 16> pool;
+    const auto root = pool.spawn();
+    const auto child = pool.spawn();
+    const auto other = pool.spawn();
+    pool.attach_child(root, child);
+    CHECK(pool.stats().live_count == 3);
+
+    pool.destroy(root);
+    CHECK(pool.stats().live_count == 1);
+    CHECK(pool.stats().retired_slots == 0);
+
+    const auto path =
+        (std::filesystem::temp_directory_path() / "louds_pool_stats_roundtrip_test.bin").string();
+    REQUIRE(pool.save_to_file(path.c_str()));
+
+    louds::ThingPool<std::int32_t, 16> restored;
+    (void)restored.spawn();
+    (void)restored.spawn();
+    REQUIRE(restored.load_from_file(path.c_str()));
+    CHECK(restored.stats().live_count == 1);
+    CHECK(restored.is_valid(other));
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("batch validation and resolution match per-ref lookups") {
+    louds::ThingPool<GameThing, 64> world;
+    std::vector<louds::ThingRef> live;
+    for (int i = 0; i < 40; ++i) {
+        const auto ref = world.spawn();
+        world.get(ref).health = i;
+        live.push_back(ref);
+    }
+    for (size_t i = 0; i < live.size(); i += 3) world.destroy(live[i]);
+    const auto reused = world.spawn();
+
+    std::vector<louds::ThingRef> targets = live;
+    targets.push_back(louds::NilRef);
+    targets.push_back({63u, 1u});
+    targets.push_back({1000u, 1u});
+    targets.push_back(reused);
+    for (int i = 0; i < 30; ++i) targets.push_back(live[static_cast<size_t>(i * 7) % live.size()]);
+
+    std::vector<std::uint64_t> bits((targets.size() + 63) / 64);
+    const auto valid = world.validate_batch(targets, bits);
+
+    std::vector<GameThing*> resolved(targets.size());
+    CHECK(world.resolve_batch(targets, resolved) == valid);
+
+    const auto& const_world = world;
+    std::vector<const GameThing*> const_resolved(targets.size());
+    CHECK(const_world.resolve_batch(targets, const_resolved) == valid);
+
+    size_t expected = 0;
+    for (size_t i = 0; i < targets.size(); ++i) {
+        const bool is_valid = world.is_valid(targets[i]);
+        expected += is_valid ? 1 : 0;
+        CHECK(((bits[i / 64] >> (i % 64)) & 1) == (is_valid ? 1u : 0u));
+        if (is_valid) {
+            CHECK(resolved[i] == &world.get(targets[i]));
+            CHECK(const_resolved[i] == resolved[i]);
+        } else {
+            CHECK(resolved[i] == nullptr);
+        }
+    }
+    CHECK(valid == expected);
+}
+
+TEST_CASE("prefetch policies do not change scans or hierarchy destruction") {
+    check_prefetch_policy_walks<louds::DefaultPoolPolicy>();
+    check_prefetch_policy_walks<DeepPrefetch>();
+    check_prefetch_policy_walks<NoPrefetch>();
+}
+
+TEST_CASE("for_each_chunk hands out 64-slot runs with active masks") {
+    louds::ThingPool<GameThing, 200> world;
+    std::vector<louds::ThingRef> refs;
+    for (int i = 0; i < 150; ++i) {
+        const auto ref = world.spawn();
+        world.get(ref).px = static_cast<float>(i);
+        world.get(ref).vx = 2.0f;
+        refs.push_back(ref);
+    }
+    for (size_t i = 0; i < refs.size(); i += 4) world.destroy(refs[i]);
+    for (size_t i = 64; i < 127; ++i) world.destroy(refs[i]);
+
+    size_t chunks = 0;
+    size_t active_slots = 0;
+    world.for_each_chunk([&](const auto& chunk) {
+        chunks++;
+        CHECK(chunk.first() % 64 == 0);
+        CHECK(chunk.size() <= 64);
+        CHECK(chunk.active_mask() != 0);
+        for (uint64_t live = chunk.active_mask(); live != 0; live &= live - 1) {
+            const auto i = static_cast<size_t>(std::countr_zero(live));
+            chunk[i].px += chunk[i].vx;
+            CHECK(world.is_valid(chunk.ref(i)));
+        }
+        active_slots += static_cast<size_t>(std::popcount(chunk.active_mask()));
+    });
+    CHECK(active_slots == world.stats().live_count);
+    CHECK(chunks == 3);
+
+    const auto& const_world = world;
+    size_t checked = 0;
+    const_world.for_each_chunk([&](louds::ThingPool<GameThing, 200>::ConstChunk chunk) {
+        for (size_t i = 0; i < chunk.size(); ++i) {
+            if (!chunk.is_active(i)) continue;
+            const auto ref = chunk.ref(i);
+            CHECK(chunk[i].px == doctest::Approx(static_cast<float>(ref.index - 1) + 2.0f));
+            checked++;
+        }
+    });
+    CHECK(checked == active_slots);
+}
+
+TEST_CASE("const pools iterate and hand out read-only views") {
+    louds::ThingPool<GameThing, 64> world;
+    std::vector<louds::ThingRef> refs;
+    for (int i = 1; i <= 10; ++i) {
+        const auto ref = world.spawn();
+        world.get(ref).health = i;
+        world.get(ref).kind = i % 2 == 0 ? ThingKind::enemy : ThingKind::player;
+        refs.push_back(ref);
+    }
+    world.destroy(refs[0]);
+
+    const auto& const_world = world;
+    static_assert(std::is_same_v<decltype(const_world.get(refs[1])), const GameThing&>);
+    static_assert(std::is_same_v<decltype(*const_world.begin()), louds::ThingPool<GameThing, 64>::ConstPoolItem>);
+
+    int sum = 0;
+    for (auto item : const_world) sum += item.data.health;
+    CHECK(sum == 54);
+
+    const louds::PoolView<const GameThing, 64> view = const_world.view();
+    CHECK(total_health(view) == doctest::Approx(54.0f));
+    CHECK(total_health(world.view()) == doctest::Approx(54.0f));
+    CHECK_FALSE(view.is_valid(refs[0]));
+    CHECK(view.get(refs[1]).health == 2);
+    CHECK(view.stats().live_count == 9);
+
+    size_t enemies = 0;
+    view.for_kind(ThingKind::enemy, [&](louds::ThingRef, const GameThing&) { enemies++; });
+    CHECK(enemies == 5);
+
+    std::atomic<int> parallel_sum{0};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 3; ++t) {
+        readers.emplace_back([view, &parallel_sum] {
+            parallel_sum += static_cast<int>(total_health(view));
+        });
+    }
+    for (auto& reader : readers) reader.join();
+    CHECK(parallel_sum.load() == 3 * 54);
+
+    auto mutable_view = world.view();
+    mutable_view.get(refs[1]).health = 100;
+    CHECK(view.get(refs[1]).health == 100);
+}
+
+TEST_CASE("command buffers play back deterministically regardless of thread split") {
+    using Buffer = louds::CommandBuffer<GameThing, 256>;
+
+    // Each enemy fires a projectile parented to itself; enemies with no health are destroyed.
+    auto run = [](size_t thread_count) {
+        auto world = std::make_unique<louds::ThingPool<GameThing, 256>>();
+        std::vector<louds::ThingRef> enemies;
+        for (int i = 0; i < 40; ++i) {
+            const auto ref = world->spawn();
+            world->get(ref) = {.kind = ThingKind::enemy, .health = i % 5};
+            enemies.push_back(ref);
+        }
+
+        std::vector<std::unique_ptr<Buffer>> buffers;
+        for (size_t t = 0; t < thread_count; ++t) buffers.push_back(std::make_unique<Buffer>());
+
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < thread_count; ++t) {
+            workers.emplace_back([&, t] {
+                Buffer& commands = *buffers[t];
+                for (size_t i = t; i < enemies.size(); i += thread_count) {
+                    const GameThing& enemy = world->get(enemies[i]);
+                    const uint64_t key = enemies[i].index;
+                    if (enemy.health == 0) {
+                        commands.destroy(key, enemies[i]);
+                        continue;
+                    }
+                    const auto shot = commands.spawn(key, {.kind = ThingKind::projectile, .px = enemy.px,
+                                                           .health = enemy.health});
+                    CHECK(shot.generation == 0);
+                    commands.attach_child(key, enemies[i], shot);
+                }
+            });
+        }
+        for (auto& worker : workers) worker.join();
+
+        std::vector<Buffer*> raw;
+        for (auto& buffer : buffers) raw.push_back(buffer.get());
+        const size_t applied = Buffer::playback(*world, raw);
+        CHECK(applied == 8 + 32 * 2);
+
+        std::vector<std::pair<louds::ThingRef, GameThing>> result;
+        for (auto item : *world) result.emplace_back(item.ref, item.data);
+        for (const auto* buffer : raw) CHECK(buffer->empty());
+        return result;
+    };
+
+    const auto single = run(1);
+    CHECK(single.size() == 32 + 32);
+    for (size_t threads : {2u, 3u, 7u}) {
+        const auto split = run(threads);
+        REQUIRE(split.size() == single.size());
+        for (size_t i = 0; i < split.size(); ++i) {
+            CHECK(split[i].first == single[i].first);
+            CHECK(split[i].second.kind == single[i].second.kind);
+            CHECK(split[i].second.health == single[i].second.health);
+        }
+    }
+}
+
+TEST_CASE("command buffer placeholders resolve after playback") {
+    louds::ThingPool<GameThing, 3> world;
+    louds::CommandBuffer<GameThing, 8> commands;
+
+    const auto parent = commands.spawn(1, {.health = 10});
+    const auto child = commands.spawn(2, {.health = 20});
+    CHECK(commands.attach_child(3, parent, child));
+    const auto overflow = commands.spawn(4);
+    CHECK(commands.destroy(0, louds::ThingRef{2, 7}));
+    CHECK(commands.size() == 5);
+    CHECK(commands.resolve(parent) == louds::NilRef);
+
+    CHECK(commands.playback(world) == 3);
+    const auto real_parent = commands.resolve(parent);
+    const auto real_child = commands.resolve(child);
+    REQUIRE(world.is_valid(real_parent));
+    REQUIRE(world.is_valid(real_child));
+    CHECK(world.get(real_child).health == 20);
+    CHECK(commands.resolve(overflow) == louds::NilRef);
+
+    CHECK(commands.destroy(0, parent));
+    CHECK(commands.playback(world) == 1);
+    CHECK_FALSE(world.is_valid(real_child));
+
+    commands.clear();
+    CHECK(commands.resolve(parent) == louds::NilRef);
+}
+
+TEST_CASE("sliced passes spread a lightly filled pool evenly across frames") {
+    auto world = std::make_unique<louds::ThingPool<GameThing, 1 << 16>>();
+    for (int i = 0; i < 400; ++i) {
+        world->spawn_with(GameThing{.kind = ThingKind::enemy});
+    }
+
+    size_t total = 0;
+    for (uint64_t frame = 0; frame < 8; ++frame) {
+        const size_t visited = world->for_kind_sliced(ThingKind::enemy, 8, frame, [](louds::ThingRef, GameThing&) {});
+        CHECK(visited == 50);
+        total += visited;
+    }
+    CHECK(total == 400);
+}
+
+TEST_CASE("sliced and budgeted for_kind passes cover every match across frames") {
+    louds::ThingPool<GameThing, 101> world;
+    for (int i = 0; i < 100; ++i) {
+        const auto ref = world.spawn();
+        world.get(ref).kind = i % 4 == 0 ? ThingKind::pickup : ThingKind::enemy;
+    }
+
+    std::vector<int> seen(101, 0);
+    size_t sliced = 0;
+    for (uint64_t frame = 10; frame < 17; ++frame) {
+        sliced += world.for_kind_sliced(ThingKind::enemy, 7, frame, [&](louds::ThingRef ref, GameThing&) {
+            seen[ref.index]++;
+        });
+    }
+    CHECK(sliced == 75);
+    for (louds::ThingIdx idx = 1; idx < 101; ++idx) {
+        CHECK(seen[idx] == ((idx - 1) % 4 == 0 ? 0 : 1));
+    }
+
+    louds::PassCursor cursor;
+    std::fill(seen.begin(), seen.end(), 0);
+    size_t frames = 0;
+    while (cursor.passes == 0) {
+        const size_t visited = world.for_kind_budget(ThingKind::enemy, cursor, 10, [&](louds::ThingRef ref, GameThing&) {
+            seen[ref.index]++;
+        });
+        CHECK(visited <= 10);
+        frames++;
+    }
+    // The eighth frame finishes the lap and spends the rest of its budget on the next one.
+    CHECK(frames == 8);
+    CHECK(cursor.next == 8);
+    for (louds::ThingIdx idx = 1; idx < 101; ++idx) {
+        const int expected = (idx - 1) % 4 == 0 ? 0 : (idx < 8 ? 2 : 1);
+        CHECK(seen[idx] == expected);
+    }
+
+    // A generous budget does at most one lap, starting where the cursor stopped.
+    cursor = {};
+    CHECK(world.for_kind_budget(ThingKind::pickup, cursor, 3, [](louds::ThingRef, GameThing&) {}) == 3);
+    const auto& const_world = world;
+    CHECK(const_world.for_kind_budget(ThingKind::pickup, cursor, 1000, [](louds::ThingRef, const GameThing&) {}) == 25);
+    CHECK(cursor.passes == 1);
+
+    CHECK(world.for_kind_budget(ThingKind::enemy, cursor, std::chrono::nanoseconds(0), [](louds::ThingRef, GameThing&) {}) == 0);
+    CHECK(world.for_kind_budget(ThingKind::enemy, cursor, std::chrono::seconds(10), [](louds::ThingRef, GameThing&) {}) == 75);
+}
+
+TEST_CASE("budgeted passes over a sparse kind stop partway through the pool") {
+    using World = louds::ThingPool<GameThing, 4096>;
+    auto world = std::make_unique<World>();
+    for (int i = 0; i < 4000; ++i) world->get(world->spawn()).kind = ThingKind::enemy;
+    const auto pickup = world->spawn();
+    world->get(pickup).kind = ThingKind::pickup;
+
+    // Scanning non-matching slots is charged against the budget, so a frame without a match ends early.
+    louds::PassCursor cursor;
+    CHECK(world->for_kind_budget(ThingKind::pickup, cursor, 2, [](louds::ThingRef, GameThing&) {}) == 0);
+    CHECK(cursor.next == 1 + 2 * World::budget_scan_per_visit);
+    CHECK(cursor.passes == 0);
+
+    size_t frames = 1;
+    size_t found = 0;
+    while (cursor.passes == 0) {
+        found += world->for_kind_budget(ThingKind::pickup, cursor, 2, [&](louds::ThingRef ref, GameThing&) {
+            CHECK(ref == pickup);
+        });
+        frames++;
+    }
+    CHECK(found == 1);
+    CHECK(frames > 20);
+
+    // A time budget is checked between matches too, so an expired one does not walk a full lap.
+    cursor = {};
+    world->for_kind_budget(ThingKind::pickup, cursor, std::chrono::nanoseconds(1), [](louds::ThingRef, GameThing&) {});
+    CHECK(cursor.passes == 0);
+}
+
+TEST_CASE("destroy_incremental invalidates a subtree at once and reclaims it over frames") {
+    auto world = std::make_unique<louds::ThingPool<GameThing, 4096>>();
+    const auto root = world->spawn();
+    std::vector<louds::ThingRef> descendants;
+    for (int i = 0; i < 300; ++i) {
+        const auto child = world->spawn();
+        world->attach_child(root, child);
+        descendants.push_back(child);
+        for (int j = 0; j < i % 4; ++j) {
+            const auto grandchild = world->spawn();
+            world->attach_child(child, grandchild);
+            descendants.push_back(grandchild);
+        }
+    }
+    const auto owner = world->spawn();
+    world->attach_child(owner, root);
+    const auto bystander = world->spawn();
+    const size_t subtree = descendants.size() + 1;
+
+    world->destroy_incremental(root);
+    CHECK_FALSE(world->is_valid(root));
+    for (const auto ref : descendants) CHECK_FALSE(world->is_valid(ref));
+    CHECK(world->is_valid(owner));
+    CHECK(world->is_valid(bystander));
+    CHECK(world->stats().live_count == 2);
+    CHECK(world->stats().pending_reclaim == subtree);
+
+    size_t iterated = 0;
+    for (auto item : *world) { (void)item; iterated++; }
+    CHECK(iterated == 2);
+
+    // Descendants may be destroyed again by gameplay without effect.
+    world->destroy(descendants[5]);
+    CHECK(world->stats().pending_reclaim == subtree);
+
+    size_t frames = 0;
+    while (world->stats().pending_reclaim > 0) {
+        CHECK(world->reclaim_destroyed(100) <= 100);
+        frames++;
+    }
+    CHECK(frames == (subtree + 99) / 100);
+    CHECK(world->reclaim_destroyed(100) == 0);
+
+    // Every reclaimed slot is reusable and fresh.
+    size_t spawned = 0;
+    while (true) {
+        const auto ref = world->spawn();
+        if (!ref) break;
+        CHECK(world->get(ref).health == 0);
+        spawned++;
+    }
+    CHECK(spawned == 4096 - 1 - 2);
+}
+
+TEST_CASE("destroy_incremental leftovers are reclaimed by spawn and by save/load") {
+    louds::ThingPool<GameThing, 8> world;
+    const auto root = world.spawn();
+    for (int i = 0; i < 6; ++i) world.attach_child(root, world.spawn());
+    world.destroy_incremental(root);
+    CHECK(world.stats().pending_reclaim == 7);
+
+    const auto path =
+        (std::filesystem::temp_directory_path() / "louds_pending_reclaim_roundtrip.bin").string();
+    REQUIRE(world.save_to_file(path.c_str()));
+    louds::ThingPool<GameThing, 8> loaded;
+    REQUIRE(loaded.load_from_file(path.c_str()));
+    CHECK(loaded.stats().pending_reclaim == 0);
+    std::filesystem::remove(path);
+
+    for (auto* pool : {&world, &loaded}) {
+        size_t spawned = 0;
+        while (pool->spawn()) spawned++;
+        CHECK(spawned == 7);
+        CHECK(pool->stats().live_count == 7);
+        CHECK(pool->stats().pending_reclaim == 0);
+    }
+}
+
+TEST_CASE("pools allocate from a high-water mark and clear in O(1)") {
+    using BigPool = louds::ThingPool<GameThing, 1 << 16>;
+    auto world = std::make_unique<BigPool>();
+    CHECK(world->high_water_mark() == 1);
+    CHECK_FALSE(world->begin() != world->end());
+
+    std::vector<louds::ThingRef> refs;
+    for (int i = 0; i < 10; ++i) refs.push_back(world->spawn());
+    CHECK(world->high_water_mark() == 11);
+    CHECK(refs.front().index == 1);
+    CHECK(refs.back().index == 10);
+
+    // Recycled slots are reused before the high-water mark moves.
+    world->destroy(refs[3]);
+    const auto recycled = world->spawn();
+    CHECK(recycled.index == refs[3].index);
+    CHECK(recycled.generation == refs[3].generation + 1);
+    CHECK(world->high_water_mark() == 11);
+
+    const auto path =
+        (std::filesystem::temp_directory_path() / "louds_high_water_roundtrip.bin").string();
+    REQUIRE(world->save_to_file(path.c_str()));
+    CHECK(std::filesystem::file_size(path) < 64 * sizeof(GameThing));
+    auto loaded = std::make_unique<BigPool>();
+    REQUIRE(loaded->load_from_file(path.c_str()));
+    std::filesystem::remove(path);
+    CHECK(loaded->high_water_mark() == 11);
+    CHECK(loaded->stats().live_count == 10);
+    CHECK(loaded->spawn().index == 11);
+
+    world->clear();
+    CHECK(world->stats().live_count == 0);
+    CHECK(world->high_water_mark() == 1);
+    for (const auto ref : refs) CHECK_FALSE(world->is_valid(ref));
+    size_t iterated = 0;
+    for (auto item : *world) { (void)item; iterated++; }
+    CHECK(iterated == 0);
+
+    // Old slots come back with bumped generations, so refs from before the clear stay stale.
+    const auto again = world->spawn();
+    CHECK(again.index == 1);
+    CHECK(again.generation == refs[0].generation + 1);
+    CHECK_FALSE(world->is_valid(refs[0]));
+    CHECK(world->get(again).health == 0);
+}
+
+TEST_CASE("pools with non-trivial payloads construct and destroy slots lazily") {
+    louds::ThingPool<std::string, 8> names;
+    const auto a = names.spawn();
+    const auto b = names.spawn();
+    names.get(a) = std::string(100, 'a');
+    names.get(b) = std::string(100, 'b');
+    names.destroy(a);
+    CHECK(names.spawn().index == a.index);
+    names.clear();
+    const auto c = names.spawn();
+    CHECK(names.get(c).empty());
+    names.get(c) = std::string(100, 'c');
+}
+
+TEST_CASE("pools copy their constructed slots and bookkeeping") {
+    using Names = louds::ThingPool<std::string, 8>;
+    Names names;
+    const auto a = names.spawn();
+    const auto b = names.spawn();
+    const auto c = names.spawn();
+    names.get(a) = std::string(100, 'a');
+    names.get(b) = std::string(100, 'b');
+    names.destroy(c);
+
+    Names copy = names;
+    CHECK(copy.get(a) == std::string(100, 'a'));
+    CHECK_FALSE(copy.is_valid(c));
+    CHECK(copy.spawn().index == c.index);
+    copy.get(b) = "changed";
+    CHECK(names.get(b) == std::string(100, 'b'));
+
+    // Assigning a smaller pool destroys the slots it no longer uses; a larger one constructs them.
+    Names small;
+    const auto only = small.spawn();
+    small.get(only) = "only";
+    const uint64_t version = copy.structural_version();
+    copy = small;
+    CHECK(copy.structural_version() > version);
+    CHECK(copy.stats().live_count == 1);
+    CHECK(copy.get(only) == "only");
+    CHECK_FALSE(copy.is_valid(b));
+    small = names;
+    CHECK(small.get(b) == std::string(100, 'b'));
+    CHECK(small.spawn().index == c.index);
+
+    // Copies keep the lazily built locality bitmap consistent.
+    louds::ThingPool<GameThing, 256, LocalityBitmap> near;
+    std::vector<louds::ThingRef> refs;
+    for (int i = 0; i < 100; ++i) refs.push_back(near.spawn());
+    near.destroy(refs[40]);
+    auto near_copy = near;
+    CHECK(near_copy.spawn_near(refs[41]).index == refs[40].index);
+    size_t spawned = 0;
+    while (near_copy.spawn()) spawned++;
+    CHECK(spawned == 255 - 100);
+}
+
+TEST_CASE("intrusive free list policy shrinks the pool and keeps allocation behaviour") {
+    using Compact = louds::ThingPool<GameThing, 64, IntrusiveFreeList>;
+    using Classic = louds::ThingPool<GameThing, 64>;
+    static_assert(sizeof(Compact) + 60 * sizeof(louds::ThingIdx) <= sizeof(Classic));
+
+    Compact world;
+    Classic reference;
+    std::vector<louds::ThingRef> refs;
+    for (int i = 0; i < 20; ++i) {
+        const auto ref = world.spawn();
+        CHECK(ref == reference.spawn());
+        refs.push_back(ref);
+    }
+    world.attach_child(refs[0], refs[1]);
+    world.attach_child(refs[0], refs[2]);
+    world.attach_child(refs[2], refs[3]);
+    reference.attach_child(refs[0], refs[1]);
+    reference.attach_child(refs[0], refs[2]);
+    reference.attach_child(refs[2], refs[3]);
+    world.destroy(refs[0]);
+    reference.destroy(refs[0]);
+    world.destroy(refs[10]);
+    reference.destroy(refs[10]);
+    for (int i = 0; i < 6; ++i) CHECK(world.spawn() == reference.spawn());
+
+    // Incremental destroy must not confuse the reclaim stack with sibling links.
+    for (int i = 5; i < 9; ++i) world.attach_child(refs[4], refs[static_cast<size_t>(i)]);
+    world.destroy_incremental(refs[4]);
+    CHECK(world.reclaim_destroyed(100) == 5);
+    CHECK(world.stats().live_count == 20 - 4 - 1 + 6 - 5);
+
+    // The destroy_later queue has its own capacity.
+    for (int i = 11; i < 15; ++i) CHECK(world.destroy_later(refs[static_cast<size_t>(i)]));
+    CHECK_FALSE(world.destroy_later(refs[15]));
+    CHECK(world.flush_destroy_later() == 4);
+
+    size_t spawned = 0;
+    while (world.spawn()) spawned++;
+    CHECK(spawned == 63 - (20 - 4 - 1 + 6 - 5 - 4));
+}
+
+TEST_CASE("snapshots load across free list layouts") {
+    louds::ThingPool<GameThing, 32, IntrusiveFreeList> compact;
+    std::vector<louds::ThingRef> refs;
+    for (int i = 0; i < 10; ++i) refs.push_back(compact.spawn());
+    compact.get(refs[7]).health = 77;
+    compact.destroy(refs[2]);
+    compact.destroy(refs[5]);
+
+    const auto path =
+        (std::filesystem::temp_directory_path() / "louds_intrusive_free_list.bin").string();
+    REQUIRE(compact.save_to_file(path.c_str()));
+
+    louds::ThingPool<GameThing, 32, IntrusiveFreeList> same;
+    REQUIRE(same.load_from_file(path.c_str()));
+    CHECK(same.spawn() == compact.spawn());
+    CHECK(same.get(refs[7]).health == 77);
+
+    louds::ThingPool<GameThing, 32> classic;
+    REQUIRE(classic.load_from_file(path.c_str()));
+    std::filesystem::remove(path);
+    CHECK(classic.stats().live_count == 8);
+    CHECK(classic.get(refs[7]).health == 77);
+    size_t spawned = 0;
+    while (classic.spawn()) spawned++;
+    CHECK(spawned == 31 - 8);
+}
+
+TEST_CASE("spawn_with initializes payloads in place under every scrub policy") {
+    louds::ThingPool<GameThing, 16> world;
+    const auto player = world.spawn_with(GameThing{.kind = ThingKind::player, .health = 90});
+    CHECK(world.get(player).kind == ThingKind::player);
+    CHECK(world.get(player).health == 90);
+    world.destroy(player);
+
+    // The recycled slot is reset before fn runs, and plain spawn() still hands out T{}.
+    int seen_health = -1;
+    const auto enemy = world.spawn_with([&](GameThing& thing) {
+        seen_health = thing.health;
+        thing.kind = ThingKind::enemy;
+    });
+    CHECK(enemy.index == player.index);
+    CHECK(seen_health == GameThing{}.health);
+    CHECK(world.get(enemy).kind == ThingKind::enemy);
+    world.destroy(enemy);
+    CHECK(world.get(world.spawn()).kind == ThingKind::none);
+
+    louds::ThingPool<GameThing, 16, EagerScrub> eager;
+    const auto doomed = eager.spawn_with(GameThing{.kind = ThingKind::pickup, .health = 5});
+    eager.destroy(doomed);
+    CHECK(eager.get(eager.spawn()).kind == ThingKind::none);
+
+    // Without scrubbing, the next occupant starts from the old bytes.
+    louds::ThingPool<GameThing, 16, NoScrub> raw;
+    const auto old = raw.spawn_with(GameThing{.kind = ThingKind::projectile, .health = 3});
+    raw.destroy(old);
+    const auto reused = raw.spawn_with([](GameThing& thing) { thing.health += 1; });
+    CHECK(raw.get(reused).kind == ThingKind::projectile);
+    CHECK(raw.get(reused).health == 4);
+    const auto fresh = raw.spawn();
+    CHECK(raw.get(fresh).kind == ThingKind::none);
+}
+
+TEST_CASE("command buffer spawns write the recorded payload once") {
+    louds::ThingPool<GameThing, 16, NoScrub> world;
+    world.destroy(world.spawn_with(GameThing{.kind = ThingKind::enemy, .health = 1}));
+
+    louds::CommandBuffer<GameThing> commands;
+    const auto placeholder = commands.spawn(0, GameThing{.kind = ThingKind::pickup, .health = 12});
+    CHECK(commands.playback(world) == 1);
+    const auto ref = commands.resolve(placeholder);
+    CHECK(world.get(ref).kind == ThingKind::pickup);
+    CHECK(world.get(ref).health == 12);
+}
+
+TEST_CASE("NoHierarchy pools drop the links and free one slot per destroy") {
+    using Flat = louds::ThingPool<GameThing, 64, louds::NoHierarchy>;
+    static_assert(sizeof(Flat) + 63 * 4 * sizeof(louds::ThingIdx) <= sizeof(louds::ThingPool<GameThing, 64>));
+    static_assert(!HasHierarchy<Flat>);
+    static_assert(HasHierarchy<louds::ThingPool<GameThing, 64>>);
+
+    Flat world;
+    std::vector<louds::ThingRef> refs;
+    for (int i = 0; i < 8; ++i) refs.push_back(world.spawn_with(GameThing{.kind = ThingKind::projectile, .health = i}));
+    world.destroy(refs[3]);
+    world.destroy_incremental(refs[5]);
+    CHECK(world.reclaim_destroyed(100) == 0);
+    CHECK_FALSE(world.is_valid(refs[3]));
+    CHECK_FALSE(world.is_valid(refs[5]));
+    CHECK(world.stats().live_count == 6);
+    CHECK(world.stats().pending_reclaim == 0);
+    CHECK(world.spawn().index == refs[5].index);
+    CHECK(world.spawn().index == refs[3].index);
+
+    // Recorded hierarchy commands have nothing to act on and are dropped.
+    louds::CommandBuffer<GameThing> commands;
+    commands.attach_child(0, refs[0], refs[1]);
+    commands.detach(1, refs[1]);
+    commands.destroy(2, refs[0]);
+    CHECK(commands.playback(world) == 1);
+    CHECK_FALSE(world.is_valid(refs[0]));
+    CHECK(world.is_valid(refs[1]));
+}
+
+TEST_CASE("NoHierarchy pools replicate and reject deltas carrying links") {
+    using Flat = louds::ThingPool<GameThing, 32, louds::NoHierarchy>;
+    Flat server;
+    Flat client;
+    louds::ReplicationBaseline<GameThing, 32> baseline;
+    std::vector<std::uint8_t> packet(Flat::max_delta_size());
+
+    const auto a = server.spawn_with(GameThing{.kind = ThingKind::pickup, .health = 7});
+    const auto b = server.spawn();
+    REQUIRE(client.apply_delta({packet.data(), server.encode_delta(baseline, packet)}));
+    server.destroy(b);
+    REQUIRE(client.apply_delta({packet.data(), server.encode_delta(baseline, packet)}));
+    CHECK(client.get(a).health == 7);
+    CHECK_FALSE(client.is_valid(b));
+
+    // A hierarchical server's stream is only accepted while it carries no links.
+    louds::ThingPool<GameThing, 32> linked;
+    louds::ReplicationBaseline<GameThing, 32> linked_baseline;
+    const auto parent = linked.spawn();
+    linked.attach_child(parent, linked.spawn());
+    Flat other;
+    CHECK_FALSE(other.apply_delta({packet.data(), linked.encode_delta(linked_baseline, packet)}));
+    CHECK(other.stats().live_count == 0);
+}
+
+TEST_CASE("spawn_near and spawn_child take free slots next to the hint") {
+    check_locality_spawns<LocalityBitmap>();
+    check_locality_spawns<IntrusiveLocality>();
+
+    // Without the bitmap, both fall back to the LIFO free-list.
+    louds::ThingPool<GameThing, 64> plain;
+    std::vector<louds::ThingRef> refs;
+    for (int i = 0; i < 20; ++i) refs.push_back(plain.spawn());
+    plain.destroy(refs[2]);
+    plain.destroy(refs[15]);
+    CHECK(plain.spawn_near(refs[3]).index == refs[15].index);
+    CHECK(plain.spawn_child(refs[0]).index == refs[2].index);
+}
+
+TEST_CASE("locality bitmap survives save/load, replication and epoch limbo") {
+    using World = louds::ThingPool<GameThing, 128, LocalityBitmap>;
+    World world;
+    std::vector<louds::ThingRef> refs;
+    for (int i = 0; i < 100; ++i) refs.push_back(world.spawn());
+    world.destroy(refs[40]);
+    world.destroy(refs[80]);
+
+    const auto path = (std::filesystem::temp_directory_path() / "louds_locality.bin").string();
+    REQUIRE(world.save_to_file(path.c_str()));
+    World loaded;
+    REQUIRE(loaded.load_from_file(path.c_str()));
+    std::filesystem::remove(path);
+    CHECK(loaded.spawn_near(refs[41]).index == refs[40].index);
+    CHECK(loaded.spawn().index == refs[80].index);
+
+    World client;
+    louds::ReplicationBaseline<GameThing, 128> baseline;
+    std::vector<std::uint8_t> packet(World::max_delta_size());
+    REQUIRE(client.apply_delta({packet.data(), world.encode_delta(baseline, packet)}));
+    CHECK(client.spawn_near(refs[78]).index == refs[80].index);
+
+    louds::EpochDomain domain;
+    world.set_epoch_domain(&domain);
+    world.destroy(refs[60]);
+    world.destroy(refs[61]);
+    world.collect_retired();
+    CHECK(world.spawn_near(refs[62]).index == refs[61].index);
+    CHECK(world.spawn_near(refs[59]).index == refs[60].index);
+    world.set_epoch_domain(nullptr);
+}
+
+TEST_CASE("reorder packs live slots by kind and remaps refs") {
+    louds::ThingPool<GameThing, 64> world;
+    std::vector<louds::ThingRef> refs;
+    for (int i = 0; i < 12; ++i) {
+        refs.push_back(world.spawn_with(GameThing{.kind = i % 2 == 0 ? ThingKind::enemy : ThingKind::player, .health = i}));
+    }
+    world.get(refs[4]).target = refs[9];
+    world.destroy(refs[0]);
+    world.destroy(refs[7]);
+    REQUIRE(world.destroy_later(refs[10]));
+
+    std::vector<louds::RefRemap> too_small(5);
+    CHECK_FALSE(world.reorder(louds::ReorderPolicy::by_kind, too_small));
+
+    std::vector<louds::RefRemap> remap(world.high_water_mark());
+    REQUIRE(world.reorder(louds::ReorderPolicy::by_kind, remap));
+    CHECK(world.high_water_mark() == 11);
+
+    // Payload refs are fixed up by the caller; stale refs map to NilRef.
+    for (auto item : world) item.data.target = louds::remap_ref(remap, item.data.target);
+    CHECK(louds::remap_ref(remap, refs[0]) == louds::NilRef);
+    CHECK(louds::remap_ref(remap, louds::ThingRef{refs[3].index, refs[3].generation + 1}) == louds::NilRef);
+
+    std::vector<ThingKind> kinds;
+    for (const auto item : world) kinds.push_back(item.data.kind);
+    CHECK(std::is_sorted(kinds.begin(), kinds.end()));
+    CHECK(kinds.size() == 10);
+
+    for (int i = 1; i < 12; ++i) {
+        if (i == 7) continue;
+        const auto moved = louds::remap_ref(remap, refs[i]);
+        REQUIRE(world.is_valid(moved));
+        CHECK(world.get(moved).health == i);
+        // Any ref that now points at a different occupant is stale.
+        if (moved != refs[i]) CHECK_FALSE(world.is_valid(refs[i]));
+    }
+    CHECK(world.get(louds::remap_ref(remap, refs[4])).target == louds::remap_ref(remap, refs[9]));
+
+    // The deferred destroy queue was remapped too.
+    CHECK(world.flush_destroy_later() == 1);
+    CHECK_FALSE(world.is_valid(louds::remap_ref(remap, refs[10])));
+    CHECK(world.stats().live_count == 9);
+    CHECK(world.spawn().index == 10);
+}
+
+TEST_CASE("reorder fails cleanly when generation limits leave no target slot") {
+    using World = louds::ThingPool<GameThing, 8, TwoBitGenerations>;
+    World world;
+    for (int i = 0; i < 3; ++i) world.destroy(world.spawn());
+    const auto a = world.spawn_with(GameThing{.kind = ThingKind::enemy});
+    world.destroy(world.spawn());
+    world.destroy(world.spawn());
+    const auto b = world.spawn_with(GameThing{.kind = ThingKind::player});
+    REQUIRE(b.generation == World::max_generation);
+
+    // b sorts first and takes a's slot; a's only other choice is b's slot, which is exhausted.
+    const auto version = world.structural_version();
+    std::vector<louds::RefRemap> remap(world.high_water_mark());
+    CHECK_FALSE(world.reorder(louds::ReorderPolicy::by_kind, remap));
+    CHECK(world.structural_version() == version);
+    CHECK(world.is_valid(a));
+    CHECK(world.is_valid(b));
+    CHECK(world.reorder(louds::ReorderPolicy::slot_order, remap));
+    CHECK(world.structural_version() != version);
+}
+
+TEST_CASE("reorder handles pools too large for stack scratch") {
+    using World = louds::ThingPool<GameThing, 1 << 20>;
+    auto world = std::make_unique<World>();
+    std::vector<louds::ThingRef> refs(1 << 19);
+    REQUIRE(world->spawn_n(refs) == refs.size());
+    for (size_t i = 0; i < refs.size(); i += 2) world->destroy(refs[i]);
+
+    std::vector<louds::RefRemap> remap(world->high_water_mark());
+    REQUIRE(world->reorder(louds::ReorderPolicy::slot_order, remap));
+    CHECK(world->high_water_mark() == (1 << 18) + 1);
+    CHECK(louds::remap_ref(remap, refs.back()).index == 1 << 18);
+}
+
+TEST_CASE("save writes large pools with pending reclamation without stack scratch") {
+    using World = louds::ThingPool<GameThing, 1 << 20>;
+    auto world = std::make_unique<World>();
+    std::vector<louds::ThingRef> refs(1 << 19);
+    REQUIRE(world->spawn_n(refs) == refs.size());
+    for (size_t i = 1; i < refs.size(); ++i) world->attach_child(refs[0], refs[i]);
+    // Unreclaimed slots make save rebuild the free-list view.
+    world->destroy_incremental(refs[0]);
+    const auto path = (std::filesystem::temp_directory_path() / "louds_large_save.bin").string();
+    CHECK(world->save_to_file(path.c_str()));
+    CHECK(std::filesystem::file_size(path) > (1u << 19) * sizeof(louds::ThingIdx));
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("reorder lays hierarchies out depth-first") {
+    louds::ThingPool<GameThing, 64> world;
+    const auto filler = world.spawn();
+    const auto root = world.spawn();
+    const auto loose = world.spawn();
+    const auto a = world.spawn();
+    const auto b = world.spawn();
+    const auto a_child = world.spawn();
+    world.attach_child(root, b);
+    world.attach_child(root, a);
+    world.attach_child(b, a_child);
+    world.destroy(filler);
+
+    std::vector<louds::RefRemap> remap(world.high_water_mark());
+    REQUIRE(world.reorder(louds::ReorderPolicy::hierarchy_dfs, remap));
+    const auto new_root = louds::remap_ref(remap, root);
+    CHECK(new_root.index == 1);
+    CHECK(louds::remap_ref(remap, b).index == 2);
+    CHECK(louds::remap_ref(remap, a_child).index == 3);
+    CHECK(louds::remap_ref(remap, a).index == 4);
+    CHECK(louds::remap_ref(remap, loose).index == 5);
+
+    // Links follow the move, so destroying the root still takes the whole subtree.
+    world.destroy(new_root);
+    CHECK(world.stats().live_count == 1);
+    CHECK(world.is_valid(louds::remap_ref(remap, loose)));
+}
+
+TEST_CASE("for_tags filters on dense tag masks") {
+    check_tag_queries<Tags32>();
+    check_tag_queries<Tags64>();
+    static_assert(sizeof(louds::ThingPool<GameThing, 64, Tags64>) ==
+                  sizeof(louds::ThingPool<GameThing, 64>) + 64 * sizeof(std::uint64_t));
+}
+
+TEST_CASE("tags reset when slots are reused, loaded or reordered") {
+    using World = louds::ThingPool<GameThing, 32, Tags32>;
+    World world;
+    const auto a = world.spawn();
+    const auto b = world.spawn();
+    world.add_tags(a, tag::burning);
+    world.add_tags(b, tag::visible);
+    world.destroy(a);
+    const auto reused = world.spawn();
+    CHECK(reused.index == a.index);
+    CHECK(world.tags(reused) == 0);
+    world.add_tags(reused, tag::sleeping);
+
+    std::vector<louds::RefRemap> remap(world.high_water_mark());
+    world.destroy(reused);
+    REQUIRE(world.reorder(louds::ReorderPolicy::slot_order, remap));
+    const auto moved = louds::remap_ref(remap, b);
+    CHECK(moved.index == 1);
+    CHECK(world.tags(moved) == tag::visible);
+
+    const auto path = (std::filesystem::temp_directory_path() / "louds_tags.bin").string();
+    REQUIRE(world.save_to_file(path.c_str()));
+    World loaded;
+    REQUIRE(loaded.load_from_file(path.c_str()));
+    std::filesystem::remove(path);
+    CHECK(loaded.tags(moved) == 0);
+    size_t visited = 0;
+    loaded.for_tags(0, tag::visible, [&](louds::ThingRef ref, GameThing&) {
+        CHECK(ref == moved);
+        visited++;
+    });
+    CHECK(visited == 1);
+}
+
+struct Inventory {
+    std::int32_t item_ids[16] = {};
+    std::int32_t count = 0;
+};
+
+TEST_CASE("side tables hold rare data and drop entries of destroyed owners") {
+    using World = louds::ThingPool<GameThing, 16>;
+    World world;
+    louds::SideTable<Inventory, World, 2> inventories(world);
+    const auto player = world.spawn();
+    const auto chest = world.spawn();
+    const auto rock = world.spawn();
+
+    REQUIRE(inventories.emplace(player, Inventory{{7}, 1}) != nullptr);
+    REQUIRE(inventories.emplace(chest) != nullptr);
+    CHECK(inventories.emplace(player, Inventory{{9}, 1})->item_ids[0] == 7);
+    CHECK(inventories.emplace(rock) == nullptr);
+    CHECK_FALSE(inventories.contains(rock));
+    CHECK(inventories.find(player)->count == 1);
+
+    world.destroy(chest);
+    CHECK(inventories.find(chest) == nullptr);
+    const auto reused = world.spawn();
+    CHECK(reused.index == chest.index);
+    CHECK(inventories.find(reused) == nullptr);
+    // Full table: the dead chest's entry is reclaimed to make room.
+    REQUIRE(inventories.emplace(rock) != nullptr);
+    CHECK(inventories.size() == 2);
+
+    size_t visited = 0;
+    inventories.for_each([&](louds::ThingRef, Inventory&) { visited++; });
+    CHECK(visited == 2);
+    CHECK(inventories.erase(rock));
+    CHECK_FALSE(inventories.erase(rock));
+    world.destroy(player);
+    CHECK(inventories.purge() == 1);
+    CHECK(inventories.size() == 0);
+}
+
+TEST_CASE("side tables follow reorder and round-trip through snapshots") {
+    using World = louds::ThingPool<GameThing, 16>;
+    World world;
+    louds::SideTable<Inventory, World> inventories(world);
+    louds::SideTable<float, World> heat(world);
+    const auto gap = world.spawn();
+    const auto player = world.spawn();
+    inventories.emplace(player, Inventory{{3, 4}, 2});
+    heat.emplace(player, 0.5f);
+    world.destroy(gap);
+
+    std::vector<louds::RefRemap> remap(world.high_water_mark());
+    REQUIRE(world.reorder(louds::ReorderPolicy::slot_order, remap));
+    inventories.remap(remap);
+    heat.remap(remap);
+    const auto moved = louds::remap_ref(remap, player);
+    REQUIRE(inventories.find(moved) != nullptr);
+    CHECK(inventories.find(moved)->item_ids[1] == 4);
+
+    const auto path = (std::filesystem::temp_directory_path() / "louds_side_tables.bin").string();
+    REQUIRE(world.save_to_file(path.c_str(), inventories, heat));
+
+    World loaded;
+    louds::SideTable<Inventory, World> loaded_inventories(loaded);
+    louds::SideTable<float, World> loaded_heat(loaded);
+    // Tables are read back in the order they were written; a mismatch leaves everything untouched.
+    CHECK_FALSE(loaded.load_from_file(path.c_str(), loaded_heat, loaded_inventories));
+    CHECK(loaded.stats().live_count == 0);
+    REQUIRE(loaded.load_from_file(path.c_str(), loaded_inventories, loaded_heat));
+    CHECK(loaded_inventories.find(moved)->count == 2);
+    CHECK(*loaded_heat.find(moved) == 0.5f);
+
+    World pool_only;
+    REQUIRE(pool_only.load_from_file(path.c_str()));
+    CHECK(pool_only.is_valid(moved));
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("large pools and side tables load without stack scratch") {
+    struct Journal {
+        char text[200] = {};
+    };
+    using World = louds::ThingPool<GameThing, 1 << 20>;
+    using Journals = louds::SideTable<Journal, World, 4096>;
+    auto world = std::make_unique<World>();
+    auto journals = std::make_unique<Journals>(*world);
+    std::vector<louds::ThingRef> refs(1 << 16);
+    REQUIRE(world->spawn_n(refs) == refs.size());
+    for (size_t i = 0; i < 4096; ++i) journals->emplace(refs[i * 16])->text[0] = 'j';
+
+    const auto path = (std::filesystem::temp_directory_path() / "louds_large_side_table.bin").string();
+    REQUIRE(world->save_to_file(path.c_str(), *journals));
+    auto loaded = std::make_unique<World>();
+    auto loaded_journals = std::make_unique<Journals>(*loaded);
+    REQUIRE(loaded->load_from_file(path.c_str(), *loaded_journals));
+    CHECK(loaded->stats().live_count == refs.size());
+    CHECK(loaded_journals->size() == 4096);
+    CHECK(loaded_journals->find(refs[4095 * 16])->text[0] == 'j');
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("for_changed_since visits spawned and touched things once per system run") {
+    using World = louds::ThingPool<GameThing, 300, ChangeTicks>;
+    World world;
+    std::vector<louds::ThingRef> refs;
+    for (int i = 0; i < 200; ++i) refs.push_back(world.spawn());
+
+    std::uint64_t last_sync = 0;
+    const auto changed = [&] {
+        std::vector<louds::ThingRef> seen;
+        world.view().for_changed_since(last_sync, [&](louds::ThingRef ref, GameThing&) { seen.push_back(ref); });
+        last_sync = world.advance_tick();
+        return seen;
+    };
+    CHECK(changed().size() == 200);
+    CHECK(changed().empty());
+
+    world.get_mut(refs[3]).health = 10;
+    world.touch(refs[150]);
+    world.get(refs[70]).health = 5;
+    world.destroy(refs[199]);
+    const auto fresh = world.spawn();
+    CHECK(world.changed_tick(refs[3]) == world.change_tick());
+    CHECK(changed() == std::vector<louds::ThingRef>{refs[3], refs[150], fresh});
+
+    // Changes made while a pass runs are picked up by the next one.
+    world.for_changed_since(0, [&](louds::ThingRef ref, GameThing&) {
+        if (ref == refs[10]) world.touch(refs[5]);
+    });
+    CHECK(changed() == std::vector<louds::ThingRef>{refs[5]});
+
+    std::vector<louds::RefRemap> remap(world.high_water_mark());
+    world.destroy(refs[0]);
+    REQUIRE(world.reorder(louds::ReorderPolicy::slot_order, remap));
+    CHECK(changed().empty());
+    world.touch(louds::remap_ref(remap, refs[198]));
+    CHECK(changed() == std::vector<louds::ThingRef>{louds::remap_ref(remap, refs[198])});
+}
+
+TEST_CASE("cached queries rescan only after structural changes") {
+    using World = louds::ThingPool<GameThing, 64>;
+    World world;
+    const auto spawn_kind = [&](ThingKind kind) {
+        return world.spawn_with([&](GameThing& thing) { thing.kind = kind; });
+    };
+    const auto player = spawn_kind(ThingKind::player);
+    const auto enemy_a = spawn_kind(ThingKind::enemy);
+    const auto enemy_b = spawn_kind(ThingKind::enemy);
+
+    size_t scans = 0;
+    louds::CachedQuery enemies(world, [&](const GameThing& thing) {
+        scans++;
+        return thing.kind == ThingKind::enemy;
+    });
+    CHECK(enemies.stale());
+    CHECK(std::ranges::equal(enemies.refs(), std::vector<louds::ThingRef>{enemy_a, enemy_b}));
+    CHECK(scans == 3);
+
+    // Payload writes and empty frames cost nothing.
+    world.get(enemy_a).health = 7;
+    int total_health = 0;
+    enemies.for_each([&](louds::ThingRef, GameThing& thing) { total_health += thing.health; });
+    CHECK(total_health == 7);
+    CHECK(enemies.size() == 2);
+    CHECK(scans == 3);
+
+    const auto version = world.structural_version();
+    world.set_kind(player, ThingKind::enemy);
+    CHECK(world.structural_version() != version);
+    CHECK(enemies.size() == 3);
+    world.destroy(enemy_a);
+    CHECK(std::ranges::equal(enemies.refs(), std::vector<louds::ThingRef>{player, enemy_b}));
+    world.attach_child(player, enemy_b);
+    CHECK(enemies.stale());
+    CHECK(enemies.size() == 2);
+
+    world.get(player).kind = ThingKind::none;
+    CHECK_FALSE(enemies.stale());
+    enemies.invalidate();
+    CHECK(std::ranges::equal(enemies.refs(), std::vector<louds::ThingRef>{enemy_b}));
+}
+
+TEST_CASE("expiry wheel queues things for destroy exactly when their time is up") {
+    using World = louds::ThingPool<GameThing, 64, louds::NoHierarchy>;
+    World world;
+    louds::ExpiryWheel<World, 8> lifetimes(world);
+    const auto bullet = world.spawn();
+    const auto effect = world.spawn();
+    const auto buff = world.spawn();
+    const auto early = world.spawn();
+    REQUIRE(lifetimes.schedule_destroy(bullet, 3));
+    REQUIRE(lifetimes.schedule_destroy(effect, 70));
+    REQUIRE(lifetimes.schedule_destroy(buff, 5000));
+    REQUIRE(lifetimes.schedule_destroy(early, 2));
+    CHECK_FALSE(lifetimes.schedule_destroy(louds::NilRef, 1));
+    CHECK_FALSE(lifetimes.schedule_destroy(bullet, lifetimes.max_delay + 1));
+
+    // A stale timer must not hit the thing that reused its slot.
+    world.destroy(early);
+    const auto reused = world.spawn();
+    REQUIRE(reused.index == early.index);
+
+    CHECK(lifetimes.advance(2) == 0);
+    CHECK(lifetimes.advance() == 1);
+    CHECK(world.flush_destroy_later() == 1);
+    CHECK_FALSE(world.is_valid(bullet));
+    CHECK(world.is_valid(reused));
+
+    CHECK(lifetimes.advance(66) == 0);
+    CHECK(lifetimes.advance() == 1);
+    world.flush_destroy_later();
+    CHECK_FALSE(world.is_valid(effect));
+
+    CHECK(lifetimes.advance(5000 - 71) == 0);
+    CHECK(world.is_valid(buff));
+    CHECK(lifetimes.advance() == 1);
+    CHECK(lifetimes.now() == 5000);
+    CHECK(lifetimes.size() == 0);
+}
+
+TEST_CASE("lifecycle hooks receive spawns and destroys in batches") {
+    using World = louds::ThingPool<GameThing, 128, LoggedLifecycle>;
+    World world;
+    louds::ThingRef wave[5];
+    CHECK(world.spawn_n(wave) == 5);
+    const auto boss = world.spawn();
+    world.attach_child(boss, wave[3]);
+    world.attach_child(wave[3], wave[4]);
+    REQUIRE(world.hooks().spawned.size() == 2);
+    CHECK(std::ranges::equal(world.hooks().spawned[0], wave));
+    CHECK(world.hooks().spawned[1] == std::vector<louds::ThingRef>{boss});
+
+    // A subtree destroy is one batch; so is a whole destroy_later queue.
+    world.destroy(boss);
+    REQUIRE(world.hooks().destroyed.size() == 1);
+    CHECK(world.hooks().destroyed[0] == std::vector<louds::ThingRef>{wave[4], wave[3], boss});
+    world.destroy_later(wave[0]);
+    world.destroy_later(wave[1]);
+    world.destroy_later(wave[4]);
+    CHECK(world.flush_destroy_later() == 2);
+    REQUIRE(world.hooks().destroyed.size() == 2);
+    CHECK(world.hooks().destroyed[1] == std::vector<louds::ThingRef>{wave[0], wave[1]});
+
+    // Batches larger than the internal buffer arrive in several calls, all before destroy returns.
+    std::vector<louds::ThingRef> swarm(100);
+    CHECK(world.spawn_n(swarm) == 100);
+    for (const auto ref : swarm) world.attach_child(wave[2], ref);
+    world.hooks().destroyed.clear();
+    world.destroy_incremental(wave[2]);
+    size_t reported = 0;
+    for (const auto& batch : world.hooks().destroyed) reported += batch.size();
+    CHECK(reported == 101);
+
+    // Slots still waiting for reclaim_destroyed() are reclaimed on demand.
+    CHECK(world.stats().live_count == 0);
+    louds::ThingRef overflow[200];
+    CHECK(world.spawn_n(overflow) == 127);
+    CHECK(overflow[199] == louds::NilRef);
+}
+
+TEST_CASE("bulk operations signal hooks with one reset") {
+    using World = louds::ThingPool<GameThing, 32, LoggedLifecycle>;
+    World world;
+    const auto a = world.spawn();
+    const auto b = world.spawn();
+    world.destroy(a);
+    const auto destroys = world.hooks().destroyed.size();
+
+    std::vector<louds::RefRemap> remap(World::max_things);
+    REQUIRE(world.reorder(louds::ReorderPolicy::slot_order, remap));
+    CHECK(world.hooks().resets == 1);
+    CHECK_FALSE(world.reorder(louds::ReorderPolicy::slot_order, {remap.data(), 0}));
+    CHECK(world.hooks().resets == 1);
+
+    const auto path = (std::filesystem::temp_directory_path() / "louds_reset_hook_test.bin").string();
+    REQUIRE(world.save_to_file(path.c_str()));
+    world.clear();
+    CHECK(world.hooks().resets == 2);
+    REQUIRE(world.load_from_file(path.c_str()));
+    CHECK(world.hooks().resets == 3);
+    CHECK_FALSE(world.load_from_file("/nonexistent/louds_reset_hook_test.bin"));
+    CHECK(world.hooks().resets == 3);
+    std::filesystem::remove(path);
+
+    World client;
+    louds::ReplicationBaseline<GameThing, 32> baseline;
+    std::vector<std::uint8_t> packet(World::max_delta_size());
+    REQUIRE(client.apply_delta({packet.data(), world.encode_delta(baseline, packet)}));
+    CHECK(client.hooks().resets == 1);
+    CHECK(client.hooks().spawned.empty());
+    CHECK(client.stats().live_count == 1);
+
+    // None of these report per-thing spawns or destroys.
+    CHECK(world.hooks().destroyed.size() == destroys);
+    CHECK(world.hooks().spawned.size() == 2);
+    CHECK(world.is_valid(louds::remap_ref(remap, b)));
+}
+
+TEST_CASE("unused hooks compile away") {
+    static_assert(sizeof(louds::ThingPool<GameThing, 64, CountedSpawns>) == sizeof(louds::ThingPool<GameThing, 64>));
+    louds::ThingPool<GameThing, 64, CountedSpawns> world;
+    SpawnCounter::spawned = 0;
+    world.spawn();
+    world.spawn_with(GameThing{});
+    world.destroy(world.spawn());
+    CHECK(SpawnCounter::spawned == 3);
+}